@@ -0,0 +1,54 @@
+#ifndef HOST_BENCH_HPP_
+#define HOST_BENCH_HPP_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <string_view>
+
+namespace bench
+{
+    //keeps the compiler from dropping a computed value or hoisting memory accesses
+    template<class T>
+    inline void keep(T const& v) { asm volatile("" : : "r,m"(v) : "memory"); }
+    inline void clobber() { asm volatile("" : : : "memory"); }
+
+    //ns per call of f(), best of a few runs of iters calls after a warm-up
+    template<class F>
+    double ns_per_op(size_t iters, F &&f)
+    {
+        using clock = std::chrono::steady_clock;
+        for(size_t i = 0; i < iters / 10; ++i)
+            f();
+        double best = 1e30;
+        for(int run = 0; run < 5; ++run)
+        {
+            auto t0 = clock::now();
+            for(size_t i = 0; i < iters; ++i)
+                f();
+            double ns = std::chrono::duration<double, std::nano>(clock::now() - t0).count() / iters;
+            if (ns < best)
+                best = ns;
+        }
+        return best;
+    }
+
+    //one result line: name, ns/op and (optional) size in bytes of the measured object
+    inline void report(std::string_view name, double ns, size_t bytes = 0)
+    {
+        if (bytes)
+            std::printf("  %-56.*s %9.1f ns/op %7zu bytes\n", (int)name.size(), name.data(), ns, bytes);
+        else
+            std::printf("  %-56.*s %9.1f ns/op\n", (int)name.size(), name.data(), ns);
+    }
+}
+
+//sections, see bench_main.cpp
+void bench_formatter();
+void bench_containers();
+void bench_function();
+void bench_float();
+void bench_slab();
+void bench_mpmc();
+
+#endif
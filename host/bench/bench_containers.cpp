@@ -0,0 +1,97 @@
+#include <cstdint>
+#include <memory>
+#include "bench.hpp"
+#include "lib_array_count.hpp"
+#include "lib_object_pool.hpp"
+#include "lib_ring_buffer.hpp"
+
+namespace
+{
+    struct Msg
+    {
+        uint32_t id;
+        uint32_t payload[7];
+    };
+
+    void bench_ring_buffer()
+    {
+        RingBuffer<uint32_t, 63> rb;
+        uint32_t v = 0;
+        bench::report("RingBuffer<u32,63> push+pop", bench::ns_per_op(10'000'000, [&]{
+            rb.push(v++);
+            bench::keep(*rb.pop());
+        }), sizeof(rb));
+
+        bench::report("RingBuffer<u32,63> 32 pushes, 32 pops (per item)", bench::ns_per_op(200'000, [&]{
+            for(int i = 0; i < 32; ++i)
+                rb.push(v++);
+            for(int i = 0; i < 32; ++i)
+                bench::keep(*rb.pop());
+        }) / 32, sizeof(rb));
+    }
+
+    void bench_object_pool()
+    {
+        static ObjectPool<Msg, 64> pool;
+        uint32_t v = 0;
+        bench::report("ObjectPool<32B,64> Acquire+Release", bench::ns_per_op(10'000'000, [&]{
+            Msg *p = pool.Acquire(v++);
+            bench::keep(p);
+            pool.Release(p);
+        }), sizeof(pool));
+
+        Msg *held[48];
+        bench::report("ObjectPool<32B,64> 48 Acquire, 48 Release (per pair)", bench::ns_per_op(200'000, [&]{
+            for(Msg *&p : held)
+                p = pool.Acquire(v++);
+            bench::clobber();
+            for(Msg *p : held)
+                pool.Release(p);
+        }) / 48, sizeof(pool));
+
+        bench::report("new+delete (reference)", bench::ns_per_op(10'000'000, [&]{
+            Msg *p = new Msg{v++};
+            bench::keep(p);
+            delete p;
+        }));
+    }
+
+    struct Entry
+    {
+        uint32_t key;
+        uint32_t value;
+
+        bool operator==(Entry const&) const = default;
+    };
+
+    void bench_array_count()
+    {
+        ArrayCount<Entry, 64> a;
+        for(uint32_t i = 0; i < 32; ++i)
+            a.push_back({i, i});
+        uint32_t key = 0;
+        bench::report("ArrayCount<8B,64> find in 32", bench::ns_per_op(10'000'000, [&]{
+            bench::keep(a.find(key++ & 31, &Entry::key));
+        }), sizeof(a));
+
+        bench::report("ArrayCount<8B,64> erase middle of 32 + push_back", bench::ns_per_op(10'000'000, [&]{
+            a.erase(a.begin() + 16);
+            a.push_back({key++, 0});
+            bench::clobber();
+        }), sizeof(a));
+
+        ArrayCount<std::unique_ptr<Entry>, 64> b;
+        for(uint32_t i = 0; i < 32; ++i)
+            b.push_back(std::make_unique<Entry>(i, i));
+        bench::report("ArrayCount<unique_ptr,64> find in 32", bench::ns_per_op(10'000'000, [&]{
+            bench::keep(b.find(key++ & 31, &Entry::key));
+        }), sizeof(b));
+    }
+}
+
+void bench_containers()
+{
+    bench_ring_buffer();
+    bench_object_pool();
+    bench_array_count();
+}
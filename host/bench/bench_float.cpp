@@ -0,0 +1,79 @@
+#include <cstdint>
+#include <cstdio>
+#include "bench.hpp"
+#include "lib_formatter.hpp"
+#include "legacy_float_formatter.hpp"
+
+namespace
+{
+    constexpr size_t kValues = 1024;
+
+    //deterministic input: sensor-like readings in [-1000, 1000) or magnitudes spread over 1e-6..1e9
+    struct values_t
+    {
+        float v[kValues];
+
+        values_t(bool wide)
+        {
+            uint32_t s = 12345;
+            auto next = [&]{ s = s * 1664525u + 1013904223u; return s >> 8; };
+            for(float &f : v)
+            {
+                if (wide)
+                {
+                    float m = 1.f + float(next() % 9000) / 1000.f;
+                    int e = int(next() % 16) - 6;
+                    for(; e > 0; --e) m *= 10.f;
+                    for(; e < 0; ++e) m /= 10.f;
+                    f = m;
+                }else
+                    f = float(int(next() % 2'000'000) - 1'000'000) / 1000.f;
+            }
+        }
+    };
+
+    template<class F>
+    double run(values_t const& vals, F &&f)
+    {
+        size_t i = 0;
+        return bench::ns_per_op(1'000'000, [&]{
+            f(vals.v[i++ & (kValues - 1)]);
+            bench::clobber();
+        });
+    }
+}
+
+void bench_float()
+{
+    char buf[64];
+    for(bool wide : {false, true})
+    {
+        const values_t vals(wide);
+        std::printf(" %s\n", wide ? "1e-6..1e9" : "[-1000, 1000)");
+        bench::report("tools::format_to {}", run(vals, [&](float v){
+            tools::format_to_silent(tools::BufferFormatter(buf, sizeof(buf), false), tools::compiled_fmt<"{}">, v);
+        }));
+        bench::report("tools::format_to {:.3}", run(vals, [&](float v){
+            tools::format_to_silent(tools::BufferFormatter(buf, sizeof(buf), false), tools::compiled_fmt<"{:.3}">, v);
+        }));
+        bench::report("previous formatter (via double) {}", run(vals, [&](float v){
+            (void)legacy::float_formatter_t<float>::format_to(tools::BufferFormatter(buf, sizeof(buf), false), std::string_view{}, v);
+        }));
+        bench::report("previous formatter (via double) {:.3}", run(vals, [&](float v){
+            (void)legacy::float_formatter_t<float>::format_to(tools::BufferFormatter(buf, sizeof(buf), false), std::string_view(".3"), v);
+        }));
+        bench::report("snprintf %g", run(vals, [&](float v){ std::snprintf(buf, sizeof(buf), "%g", v); }));
+        bench::report("snprintf %.3f", run(vals, [&](float v){ std::snprintf(buf, sizeof(buf), "%.3f", v); }));
+    }
+
+    //a few samples side by side
+    const float samples[] = {0.1f, 21.37f, -3.14159f, 1e-5f, 123456.7f, 3.4e38f};
+    for(float v : samples)
+    {
+        char a[32], b[32];
+        size_t na = tools::format_to_silent(tools::BufferFormatter(a, sizeof(a), false), tools::compiled_fmt<"{}">, v);
+        size_t nb = *legacy::float_formatter_t<float>::format_to(tools::BufferFormatter(b, sizeof(b), false), std::string_view{}, v);
+        std::snprintf(buf, sizeof(buf), "%g", v);
+        std::printf("  %-16.*s previous %-24.*s %%g %s\n", (int)na, a, (int)nb, b, buf);
+    }
+}
@@ -0,0 +1,21 @@
+#include "bench.hpp"
+#include "fmt_candidates.hpp"
+
+void bench_formatter()
+{
+    constexpr size_t kIters = 1'000'000;
+    char buf[64];
+    int i = 0;
+    auto run = [&](auto fmt){
+        return bench::ns_per_op(kIters, [&]{
+            bench::keep(fmt(buf, sizeof(buf), i++, "sensor", 0xbeefu));
+            bench::clobber();
+        });
+    };
+    bench::report("tools::format_to, compiled format", run(fmt_tools));
+    bench::report("tools::format_to, runtime format", run(fmt_tools_runtime));
+    bench::report("snprintf", run(fmt_snprintf));
+#if defined(__cpp_lib_format)
+    bench::report("std::format_to_n", run(fmt_std));
+#endif
+}
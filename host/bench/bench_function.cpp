@@ -0,0 +1,72 @@
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include "bench.hpp"
+#include "lib_function.hpp"
+
+namespace
+{
+    //opaque to the optimizer: the call can't be inlined away
+    template<class F>
+    [[gnu::noinline]] int call(F &f, int v) { return f(v); }
+
+    //64-byte event message, non-trivial copy like a real one with owned members
+    struct Msg
+    {
+        uint32_t id;
+        uint32_t payload[15];
+
+        Msg(uint32_t i): id(i), payload{} {}
+        Msg(Msg const& r): id(r.id) { std::memcpy(payload, r.payload, sizeof(payload)); bench::clobber(); }
+    };
+    static_assert(sizeof(Msg) == 64);
+
+    template<class F>
+    [[gnu::noinline]] void dispatch(F &f, Msg const& m) { f(m); }
+
+    void bench_dispatch()
+    {
+        constexpr size_t kIters = 20'000'000;
+        uint32_t sum = 0;
+        Msg m(1);
+        auto byValue = [&sum](Msg v){ sum += v.id; };
+        auto byRef = [&sum](Msg const& v){ sum += v.id; };
+
+        GenericCallback<void(Msg)> fixedValue(byValue);
+        GenericCallback<void(Msg const&)> fixedRef(byRef);
+        std::function<void(Msg)> stdValue(byValue);
+        std::function<void(Msg const&)> stdRef(byRef);
+        bench::report("FixedFunction void(Msg64), lvalue", bench::ns_per_op(kIters, [&]{ dispatch(fixedValue, m); }));
+        bench::report("std::function void(Msg64), lvalue", bench::ns_per_op(kIters, [&]{ dispatch(stdValue, m); }));
+        bench::report("FixedFunction void(Msg64 const&)", bench::ns_per_op(kIters, [&]{ dispatch(fixedRef, m); }));
+        bench::report("std::function void(Msg64 const&)", bench::ns_per_op(kIters, [&]{ dispatch(stdRef, m); }));
+        bench::keep(sum);
+    }
+}
+
+void bench_function()
+{
+    constexpr size_t kIters = 20'000'000;
+    int base = 3;
+    auto small = [&base](int v){ return v + base; };
+    int v = 0;
+
+    GenericCallback<int(int)> fixed{auto(small)};
+    std::function<int(int)> stdf(small);
+    bench::report("FixedFunction<48> invoke", bench::ns_per_op(kIters, [&]{ bench::keep(call(fixed, v++)); }), sizeof(fixed));
+    bench::report("std::function invoke", bench::ns_per_op(kIters, [&]{ bench::keep(call(stdf, v++)); }), sizeof(stdf));
+
+    //too big for std::function's small buffer: it goes to the heap
+    struct { int pad[8]; int *pBase; } big{{}, &base};
+    auto large = [big](int v){ return v + *big.pBase; };
+    bench::report("FixedFunction<48> construct+invoke, 40B capture", bench::ns_per_op(kIters / 4, [&]{
+        GenericCallback<int(int)> f{auto(large)};
+        bench::keep(call(f, v++));
+    }));
+    bench::report("std::function construct+invoke, 40B capture", bench::ns_per_op(kIters / 4, [&]{
+        std::function<int(int)> f(large);
+        bench::keep(call(f, v++));
+    }));
+
+    bench_dispatch();
+}
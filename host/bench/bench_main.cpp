@@ -0,0 +1,38 @@
+#include <cstdio>
+#include <string_view>
+#include "bench.hpp"
+
+//usage: esp_generic_bench [section...], runs all sections without arguments
+struct section_t
+{
+    std::string_view name;
+    void (*run)();
+};
+
+static const section_t g_Sections[] = {
+    {"format", bench_formatter},
+    {"containers", bench_containers},
+    {"function", bench_function},
+    {"float", bench_float},
+    {"slab", bench_slab},
+    {"mpmc", bench_mpmc},
+};
+
+int main(int argc, char **argv)
+{
+    int res = 1;
+    for(section_t const& s : g_Sections)
+    {
+        bool selected = argc < 2;
+        for(int i = 1; i < argc; ++i)
+            selected = selected || s.name == argv[i];
+        if (!selected)
+            continue;
+        std::printf("%.*s\n", (int)s.name.size(), s.name.data());
+        s.run();
+        res = 0;
+    }
+    if (res)
+        std::fprintf(stderr, "unknown section\n");
+    return res;
+}
@@ -0,0 +1,102 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+#include "bench.hpp"
+#include "lib_ring_buffer.hpp"
+#include "lib_thread_lock.hpp"
+
+namespace
+{
+    constexpr size_t kItems = 400'000;
+    constexpr size_t kConsumers = 2;
+
+    MpmcQueue<uint64_t, 256> g_Queue;
+    RingBuffer<uint64_t, 127> g_Locked;
+    thread::SpinLock g_Lock;
+
+    struct mpmc_t
+    {
+        static bool push(uint64_t v) { return g_Queue.push(v); }
+        static std::optional<uint64_t> pop() { return g_Queue.pop(); }
+    };
+
+    struct locked_t
+    {
+        static bool push(uint64_t v) { std::lock_guard l(g_Lock); return g_Locked.push(v).has_value(); }
+        static std::optional<uint64_t> pop() { std::lock_guard l(g_Lock); return g_Locked.pop(); }
+    };
+
+    //items are producer << 32 | sequence: every consumer must see each producer's sequence increasing,
+    //all of them together every item exactly once (count and sum). Returns ns/item, negative on a failed check
+    template<class Q>
+    double run(size_t producers)
+    {
+        const size_t perProducer = kItems / producers;
+        const size_t total = perProducer * producers;
+        std::atomic<size_t> consumed{0};
+        std::atomic<uint64_t> sum{0};
+        std::atomic<bool> ok{true};
+
+        auto t0 = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for(size_t p = 0; p < producers; ++p)
+        {
+            threads.emplace_back([&, p]{
+                for(uint64_t i = 0; i < perProducer; ++i)
+                {
+                    //yield when blocked: the host may have fewer cores than threads
+                    while(!Q::push(uint64_t(p) << 32 | i))
+                        std::this_thread::yield();
+                }
+            });
+        }
+        for(size_t c = 0; c < kConsumers; ++c)
+        {
+            threads.emplace_back([&]{
+                std::vector<int64_t> last(producers, -1);
+                uint64_t localSum = 0;
+                while(consumed.load(std::memory_order_relaxed) < total)
+                {
+                    std::optional<uint64_t> v = Q::pop();
+                    if (!v)
+                    {
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    const size_t p = *v >> 32;
+                    const int64_t seq = int64_t(*v & 0xffffffff);
+                    if (p >= producers || seq <= last[p])
+                        ok = false;
+                    else
+                        last[p] = seq;
+                    localSum += *v;
+                    consumed.fetch_add(1, std::memory_order_relaxed);
+                }
+                sum += localSum;
+            });
+        }
+        for(auto &t : threads)
+            t.join();
+        const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / double(total);
+
+        uint64_t expected = 0;
+        for(uint64_t p = 0; p < producers; ++p)
+            expected += (p << 32) * perProducer + perProducer * (perProducer - 1) / 2;
+        if (!ok || consumed != total || sum != expected)
+            return -1;
+        return ns;
+    }
+}
+
+void bench_mpmc()
+{
+    std::printf("  %zu items, %zu consumers, ns/item (-1: check failed)\n", kItems, kConsumers);
+    std::printf("  %-10s %10s %18s\n", "producers", "MpmcQueue", "RingBuffer+lock");
+    for(size_t producers : {1, 2, 4, 8})
+        std::printf("  %-10zu %10.1f %18.1f\n", producers, run<mpmc_t>(producers), run<locked_t>(producers));
+}
@@ -0,0 +1,66 @@
+#include <cstdint>
+#include <cstdlib>
+#include <memory_resource>
+#include <vector>
+#include "bench.hpp"
+#include "lib_slab_resource.hpp"
+
+namespace
+{
+    constexpr size_t kBatch = 32;
+
+    using Slabs = SlabResource<slab_class_t{16, 32}, slab_class_t{32, 32}, slab_class_t{64, 32}, slab_class_t{128, 32}, slab_class_t{256, 32}>;
+    Slabs g_Slabs;
+
+    //per round: kBatch allocations of 8..248 bytes, then all of them are freed
+    struct sizes_t
+    {
+        size_t sz[kBatch];
+
+        sizes_t()
+        {
+            uint32_t s = 4711;
+            for(size_t &v : sz)
+            {
+                s = s * 1664525u + 1013904223u;
+                v = 8 + (s >> 8) % 241;
+            }
+        }
+    };
+
+    template<class Alloc, class Free>
+    double run(sizes_t const& sizes, Alloc &&alloc, Free &&free)
+    {
+        void *p[kBatch];
+        return bench::ns_per_op(100'000, [&]{
+            for(size_t i = 0; i < kBatch; ++i)
+                p[i] = alloc(sizes.sz[i]);
+            bench::clobber();
+            for(size_t i = 0; i < kBatch; ++i)
+                free(p[i], sizes.sz[i]);
+        }) / kBatch;
+    }
+}
+
+void bench_slab()
+{
+    const sizes_t sizes;
+    bench::report("SlabResource allocate+deallocate", run(sizes,
+                [](size_t n){ return g_Slabs.allocate(n); },
+                [](void *p, size_t n){ g_Slabs.deallocate(p, n); }), sizeof(g_Slabs));
+    bench::report("malloc+free", run(sizes,
+                [](size_t n){ return std::malloc(n); },
+                [](void *p, size_t n){ std::free(p); }));
+    std::pmr::unsynchronized_pool_resource poolRes;
+    bench::report("std::pmr::unsynchronized_pool_resource", run(sizes,
+                [&](size_t n){ return poolRes.allocate(n); },
+                [&](void *p, size_t n){ poolRes.deallocate(p, n); }));
+
+    std::printf("  %-8s %10s %6s %10s %10s\n", "class", "allocs", "live", "highWater", "overflows");
+    for(size_t c = 0; c < Slabs::kClasses; ++c)
+    {
+        slab_class_stats_t const& s = g_Slabs.ClassStats(c);
+        std::printf("  %-8zu %10u %6u %10u %10u\n", Slabs::kClassList[c].size, s.allocs, s.live, s.highWater, s.overflows);
+    }
+    std::printf("  upstream %u\n", g_Slabs.UpstreamAllocs());
+}
@@ -0,0 +1,18 @@
+#ifndef HOST_BENCH_FMT_CANDIDATES_HPP_
+#define HOST_BENCH_FMT_CANDIDATES_HPP_
+
+#include <cstddef>
+#if __has_include(<format>)
+#include <format>
+#endif
+
+//the same line produced by each formatting candidate, one translation unit per candidate
+//so that their code size can be compared (bench_code_size target)
+size_t fmt_tools(char *pBuf, size_t n, int i, const char *pStr, unsigned h);
+size_t fmt_tools_runtime(char *pBuf, size_t n, int i, const char *pStr, unsigned h);
+size_t fmt_snprintf(char *pBuf, size_t n, int i, const char *pStr, unsigned h);
+#if defined(__cpp_lib_format)
+size_t fmt_std(char *pBuf, size_t n, int i, const char *pStr, unsigned h);
+#endif
+
+#endif
@@ -0,0 +1,7 @@
+#include <cstdio>
+#include "fmt_candidates.hpp"
+
+size_t fmt_snprintf(char *pBuf, size_t n, int i, const char *pStr, unsigned h)
+{
+    return std::snprintf(pBuf, n, "id %d name %s flags %08x", i, pStr, h);
+}
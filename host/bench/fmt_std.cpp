@@ -0,0 +1,8 @@
+#include "fmt_candidates.hpp"
+
+#if defined(__cpp_lib_format)
+size_t fmt_std(char *pBuf, size_t n, int i, const char *pStr, unsigned h)
+{
+    return std::format_to_n(pBuf, n, "id {} name {} flags {:08x}", i, pStr, h).size;
+}
+#endif
@@ -0,0 +1,12 @@
+#include "lib_formatter.hpp"
+#include "fmt_candidates.hpp"
+
+size_t fmt_tools(char *pBuf, size_t n, int i, const char *pStr, unsigned h)
+{
+    return tools::format_to_silent(tools::BufferFormatter(pBuf, n, false), tools::compiled_fmt<"id {} name {} flags {:08x}">, i, pStr, h);
+}
+
+size_t fmt_tools_runtime(char *pBuf, size_t n, int i, const char *pStr, unsigned h)
+{
+    return tools::format_to_silent(tools::BufferFormatter(pBuf, n, false), "id {} name {} flags {:08x}", i, pStr, h);
+}
@@ -0,0 +1,52 @@
+#ifndef HOST_STUB_FREERTOS_H_
+#define HOST_STUB_FREERTOS_H_
+
+//host build stand-in for the FreeRTOS parts this component uses, not an emulation:
+//a single "core", tasks are detached std::threads and masking interrupts excludes all other threads
+#include <atomic>
+#include <cstdint>
+#include <sys/time.h>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdPASS pdTRUE
+#define portMAX_DELAY TickType_t(0xffffffff)
+#define portNUM_PROCESSORS 1
+
+inline BaseType_t xPortGetCoreID() { return 0; }
+
+namespace host_stub
+{
+    inline std::atomic_flag g_InterruptMask;
+    inline thread_local UBaseType_t t_MaskDepth = 0;
+
+    //nests like the real mask: returns the state to restore
+    inline UBaseType_t set_interrupt_mask()
+    {
+        if (!t_MaskDepth)
+        {
+            while(g_InterruptMask.test_and_set(std::memory_order_acquire))
+                g_InterruptMask.wait(true, std::memory_order_relaxed);
+        }
+        return t_MaskDepth++;
+    }
+
+    inline void clear_interrupt_mask(UBaseType_t prev)
+    {
+        t_MaskDepth = prev;
+        if (!prev)
+        {
+            g_InterruptMask.clear(std::memory_order_release);
+            g_InterruptMask.notify_one();
+        }
+    }
+}
+
+#define portSET_INTERRUPT_MASK_FROM_ISR() host_stub::set_interrupt_mask()
+#define portCLEAR_INTERRUPT_MASK_FROM_ISR(prev) host_stub::clear_interrupt_mask(prev)
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef HOST_STUB_FREERTOS_TASK_H_
+#define HOST_STUB_FREERTOS_TASK_H_
+
+#include <thread>
+#include "FreeRTOS.h"
+
+#define tskIDLE_PRIORITY 0
+
+typedef void (*TaskFunction_t)(void *);
+struct tskTaskControlBlock;
+typedef tskTaskControlBlock* TaskHandle_t;
+
+//stack size and priority are ignored, the task runs on a detached std::thread
+inline BaseType_t xTaskCreate(TaskFunction_t f, const char *pName, uint32_t stackSize, void *pParam, UBaseType_t prio, TaskHandle_t *pHandle)
+{
+    static int g_Tasks = 0;
+    std::thread(f, pParam).detach();
+    if (pHandle)
+        *pHandle = (TaskHandle_t)&g_Tasks;
+    return pdPASS;
+}
+
+//the thread ends when its function returns
+inline void vTaskDelete(TaskHandle_t h) {}
+
+#endif
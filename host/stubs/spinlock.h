@@ -0,0 +1,37 @@
+#ifndef HOST_STUB_SPINLOCK_H_
+#define HOST_STUB_SPINLOCK_H_
+
+//host build stand-in for ESP-IDF's spinlock.h.
+//Blocks in atomic_flag::wait instead of spinning: the host may have fewer cores than threads
+#include <atomic>
+#include <cstdint>
+
+#define SPINLOCK_NO_WAIT 0
+#define SPINLOCK_WAIT_FOREVER (-1)
+
+typedef struct
+{
+    std::atomic_flag lock;
+} spinlock_t;
+
+static inline void spinlock_initialize(spinlock_t *pLock) { pLock->lock.clear(); }
+
+//any timeout other than SPINLOCK_NO_WAIT waits forever
+static inline bool spinlock_acquire(spinlock_t *pLock, int32_t timeout)
+{
+    while(pLock->lock.test_and_set(std::memory_order_acquire))
+    {
+        if (timeout == SPINLOCK_NO_WAIT)
+            return false;
+        pLock->lock.wait(true, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+static inline void spinlock_release(spinlock_t *pLock)
+{
+    pLock->lock.clear(std::memory_order_release);
+    pLock->lock.notify_one();
+}
+
+#endif
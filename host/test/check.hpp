@@ -0,0 +1,19 @@
+#ifndef HOST_TEST_CHECK_HPP_
+#define HOST_TEST_CHECK_HPP_
+
+#include <cstdio>
+
+//host tests are plain executables: failed checks are printed and make main() return 1
+inline int g_CheckFailures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            ++g_CheckFailures; \
+        } \
+    } while(0)
+
+#define CHECK_RESULT() (g_CheckFailures ? 1 : 0)
+
+#endif
@@ -0,0 +1,93 @@
+//DeferredLog with several producers and a single drainer: every record comes out exactly once.
+//Oversized string/span arguments are truncated to fit a record instead of dropping it.
+//  test_deferred_log [records per producer]
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+#include "check.hpp"
+#include "lib_deferred_log.hpp"
+
+namespace
+{
+    constexpr uint32_t kProducers = 4;
+
+    tools::DeferredLog<1024> g_Log;
+
+    void check_all_once(uint32_t perProducer)
+    {
+        std::vector<uint8_t> seen(kProducers * perProducer, 0);
+        std::atomic<bool> done{false};
+        size_t bad = 0;
+        auto sink = [&](uint32_t, std::string_view line){
+            unsigned p, i;
+            if (std::sscanf(std::string(line).c_str(), "p%u i%u", &p, &i) != 2 || p >= kProducers || i >= perProducer)
+                ++bad;
+            else
+                ++seen[p * perProducer + i];
+        };
+
+        std::thread drainer([&]{
+            while(!done.load(std::memory_order_acquire))
+            {
+                if (!g_Log.drain(sink))
+                    std::this_thread::yield();
+            }
+            g_Log.drain(sink);
+        });
+        std::vector<std::thread> producers;
+        for(uint32_t p = 0; p < kProducers; ++p)
+        {
+            producers.emplace_back([p, perProducer]{
+                for(uint32_t i = 0; i < perProducer; ++i)
+                {
+                    //a full ring drops the record, retry until the drainer catches up
+                    while(!g_Log.write(tools::compiled_fmt<"p{} i{} {}">, p, i, "payload"))
+                        std::this_thread::yield();
+                }
+            });
+        }
+        for(auto &t : producers)
+            t.join();
+        done.store(true, std::memory_order_release);
+        drainer.join();
+
+        CHECK(bad == 0);
+        size_t wrong = 0;
+        for(uint8_t n : seen)
+            wrong += n != 1;
+        CHECK(wrong == 0);
+    }
+
+    void check_truncation()
+    {
+        const std::string big(1000, 'a');
+        const uint8_t bytes[300] = {};
+        const uint32_t truncated = g_Log.truncated();
+        CHECK(g_Log.write(tools::compiled_fmt<"{}|{}">, 7, std::string_view(big)));
+        CHECK(g_Log.write(tools::compiled_fmt<"{}|{}">, 7, std::span<const uint8_t>(bytes)));
+        CHECK(g_Log.truncated() == truncated + 2);
+
+        std::vector<std::string> lines;
+        g_Log.drain([&](uint32_t, std::string_view line){ lines.emplace_back(line); });
+        CHECK(lines.size() == 2);
+        for(auto const& l : lines)
+        {
+            //cut short but not empty: as much content as fits a record
+            CHECK(l.starts_with("7|"));
+            CHECK(l.size() > 2 + decltype(g_Log)::kMaxRecordSize / 2);
+            CHECK(l.size() < 2 + 2 * decltype(g_Log)::kMaxRecordSize);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const uint32_t perProducer = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+    check_all_once(perProducer);
+    check_truncation();
+    std::printf("records: %u, dropped on a full ring (retried): %u\n", kProducers * perProducer, g_Log.dropped());
+    return CHECK_RESULT();
+}
@@ -0,0 +1,90 @@
+//copies and moves of arguments on their way through FixedFunction/FunctionRef to the target
+#include <utility>
+#include "check.hpp"
+#include "lib_function.hpp"
+#include "lib_function_ref.hpp"
+
+namespace
+{
+    struct counts_t
+    {
+        int copies = 0;
+        int moves = 0;
+        bool operator==(counts_t const&) const = default;
+    };
+
+    counts_t g_Counts;
+
+    //64 bytes, like an event message
+    struct Msg
+    {
+        int id = 0;
+        bool movedFrom = false;
+        char payload[56] = {};
+
+        Msg(int i): id(i) {}
+        Msg(Msg const& r): id(r.id) { ++g_Counts.copies; }
+        Msg(Msg &&r): id(r.id) { r.movedFrom = true; ++g_Counts.moves; }
+    };
+
+    //calls f with an lvalue and with a prvalue and checks the counts of each call
+    template<class F>
+    void check_calls(F &&f, counts_t lvalue, counts_t prvalue)
+    {
+        Msg m(1);
+        g_Counts = {};
+        f(m);
+        CHECK(g_Counts == lvalue);
+        CHECK(!m.movedFrom);
+
+        g_Counts = {};
+        f(Msg(2));
+        CHECK(g_Counts == prvalue);
+    }
+
+    int g_Sum = 0;
+}
+
+int main()
+{
+    auto byValue = [](Msg m){ g_Sum += m.id; };
+    auto byRef = [](Msg const& m){ g_Sum += m.id; };
+    auto byRvalue = [](Msg &&m){ g_Sum += m.id; };
+
+    //by value: one copy from an lvalue (the caller's object stays untouched), the move is the target's own parameter
+    check_calls(GenericCallback<void(Msg)>(byValue), {1, 1}, {0, 1});
+    check_calls(TrivialCallback<void(Msg)>(byValue), {1, 1}, {0, 1});
+    check_calls(FunctionRef<void(Msg)>(byValue), {1, 1}, {0, 1});
+    check_calls(GenericCallback<void(Msg)>(+byValue), {1, 1}, {0, 1});
+
+    //by reference: nothing
+    check_calls(GenericCallback<void(Msg const&)>(byRef), {0, 0}, {0, 0});
+    check_calls(TrivialCallback<void(Msg const&)>(byRef), {0, 0}, {0, 0});
+    check_calls(FunctionRef<void(Msg const&)>(byRef), {0, 0}, {0, 0});
+
+    //rvalue reference parameter
+    {
+        GenericCallback<void(Msg&&)> f(byRvalue);
+        g_Counts = {};
+        f(Msg(3));
+        CHECK(g_Counts == (counts_t{0, 0}));
+    }
+
+    //a by-value target behind a reference signature copies exactly once
+    {
+        GenericCallback<void(Msg const&)> f(byValue);
+        Msg m(4);
+        g_Counts = {};
+        f(m);
+        CHECK(g_Counts == (counts_t{1, 0}));
+    }
+
+    //an argument of a different type is converted into the parameter once
+    {
+        GenericCallback<void(Msg)> f(byValue);
+        g_Counts = {};
+        f(5);
+        CHECK(g_Counts == (counts_t{0, 1}));
+    }
+    return CHECK_RESULT();
+}
@@ -0,0 +1,66 @@
+//compiles the header-only parts of the library: each class template is explicitly
+//instantiated, so its members are compiled even where nothing else uses them yet
+#include <string_view>
+#include "lib_arena.hpp"
+#include "lib_array_count.hpp"
+#include "lib_deferred_log.hpp"
+#include "lib_formatter.hpp"
+#include "lib_function.hpp"
+#include "lib_function_ref.hpp"
+#include "lib_magazine_pool.hpp"
+#include "lib_misc_helpers.hpp"
+#include "lib_object_pool.hpp"
+#include "lib_pool_stats.hpp"
+#include "lib_ring_buffer.hpp"
+#include "lib_signal.hpp"
+#include "lib_slab_resource.hpp"
+
+namespace
+{
+    struct sink_t
+    {
+        void operator()(std::string_view) {}
+    };
+
+    struct async_sink_t: sink_t
+    {
+        void wait() {}
+    };
+
+    struct entry_t
+    {
+        uint32_t key;
+        bool operator==(entry_t const&) const = default;
+    };
+}
+
+template class Arena<256>;
+template class ArrayCount<entry_t, 8>;
+template class RingBuffer<uint32_t, 15>;
+template class SpscRingBuffer<uint32_t, 16>;
+template struct MpmcQueue<uint32_t, 16>;
+template class ObjectPool<uint64_t, 8>;
+template class LockFreeObjectPool<uint64_t, 8>;
+template class MagazinePool<LockFreeObjectPool<uint64_t, 8>>;
+template class ObjectPool<uint64_t, 8, PoolStats>;
+template class HandlePool<uint64_t, 8>;
+template class SlabResource<slab_class_t{16, 4}, slab_class_t{64, 2}>;
+template class FixedFunction<16, int(int)>;
+template class FixedFunction<16, int(int), FunctionHeapSpill>;
+template class FixedFunction<16, int(int), FunctionTrivialOnly>;
+template class FunctionRef<int(int)>;
+template class Signal<void(int), 4>;
+template struct tools::ChunkedFormatter<16, sink_t>;
+template struct tools::ChunkedFormatter<16, async_sink_t, 2>;
+template class tools::DeferredLog<256>;
+
+//member templates aren't covered by explicit instantiation
+[[maybe_unused]] static void format_pool_stats(char (&buf)[256], PoolStats<8> const& s)
+{
+    tools::format_to(tools::BufferFormatter(buf, sizeof(buf), true), tools::compiled_fmt<"{}">, s);
+}
+
+int main()
+{
+    return 0;
+}
@@ -0,0 +1,112 @@
+//LockFreeObjectPool under several threads: no slot is handed out twice, nothing is lost.
+//Prints the throughput next to an ObjectPool behind thread::SpinLock.
+//  test_lockfree_pool [rounds per thread]
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "check.hpp"
+#include "lib_object_pool.hpp"
+#include "lib_thread_lock.hpp"
+
+namespace
+{
+    constexpr size_t kSlots = 256;
+    constexpr size_t kPerRound = 8;//objects held by a thread at once
+
+    struct Obj
+    {
+        uint32_t owner;
+        uint32_t round;
+    };
+
+    LockFreeObjectPool<Obj, kSlots> g_LockFree;
+    ObjectPool<Obj, kSlots> g_Locked;
+    thread::SpinLock g_Lock;
+
+    struct lockfree_t
+    {
+        static Obj* Acquire(Obj v) { return g_LockFree.Acquire(v); }
+        static void Release(Obj *p) { g_LockFree.Release(p); }
+    };
+
+    struct locked_t
+    {
+        static Obj* Acquire(Obj v) { std::lock_guard l(g_Lock); return g_Locked.Acquire(v); }
+        static void Release(Obj *p) { std::lock_guard l(g_Lock); g_Locked.Release(p); }
+    };
+
+    //returns ns per Acquire+Release pair
+    template<class Pool>
+    double run(size_t threads, size_t rounds, std::atomic<size_t> &errors)
+    {
+        std::atomic<bool> go{false};
+        std::vector<std::thread> workers;
+        for(size_t t = 0; t < threads; ++t)
+        {
+            workers.emplace_back([&, t]{
+                while(!go.load(std::memory_order_acquire))
+                    std::this_thread::yield();
+                Obj *held[kPerRound];
+                for(uint32_t r = 0; r < rounds; ++r)
+                {
+                    for(Obj *&p : held)
+                    {
+                        //threads * kPerRound <= kSlots: a failure would be a lost slot
+                        p = Pool::Acquire({uint32_t(t), r});
+                        if (!p)
+                            ++errors;
+                    }
+                    for(Obj *p : held)
+                    {
+                        //another thread writing into one of ours: the slot was handed out twice
+                        if (p && (p->owner != t || p->round != r))
+                            ++errors;
+                    }
+                    for(Obj *p : held)
+                    {
+                        if (p)
+                            Pool::Release(p);
+                    }
+                }
+            });
+        }
+        auto t0 = std::chrono::steady_clock::now();
+        go.store(true, std::memory_order_release);
+        for(auto &w : workers)
+            w.join();
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+        return ns / double(threads * rounds * kPerRound);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const size_t rounds = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+    std::printf("threads  lock-free ns/pair  spinlock ns/pair\n");
+    for(size_t threads : {1, 2, 4, 8})
+    {
+        std::atomic<size_t> errors{0};
+        const double lf = run<lockfree_t>(threads, rounds, errors);
+        const double sl = run<locked_t>(threads, rounds, errors);
+        std::printf("%7zu  %17.1f  %16.1f\n", threads, lf, sl);
+        CHECK(errors == 0);
+    }
+
+    //every slot is free again
+    Obj *all[kSlots];
+    size_t n = 0;
+    for(Obj *&p : all)
+        n += (p = g_LockFree.Acquire()) != nullptr;
+    CHECK(n == kSlots);
+    CHECK(g_LockFree.Acquire() == nullptr);
+    for(Obj *p : all)
+    {
+        if (p)
+            g_LockFree.Release(p);
+    }
+    return CHECK_RESULT();
+}
@@ -0,0 +1,161 @@
+#ifndef LIB_ARENA_HPP_
+#define LIB_ARENA_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <span>
+#include <utility>
+#include "lib_misc_helpers.hpp"
+
+//bump-pointer (monotonic) allocator over a fixed memory region.
+//Allocation is a pointer increment, nothing is freed individually: Reset() or Rewind() to
+//a Mark() release everything allocated after it at once. Destructors are never called.
+//Once the region is exhausted allocate() returns nullptr, unless an upstream resource is given:
+//then further blocks (at least the size of the initial region) are chained from it and handed back on Reset/Rewind.
+//A failing upstream allocation is not turned into nullptr: whatever it throws (std::bad_alloc) propagates.
+class ArenaBase
+{
+    struct Block
+    {
+        Block *pPrev;
+        size_t size;
+    };
+public:
+    struct mark_t
+    {
+        Block *pBlock;
+        std::byte *pCur;
+    };
+
+    ArenaBase(std::span<std::byte> region, std::pmr::memory_resource *pUpstream = nullptr):
+        m_pBase(region.data())
+        ,m_pCur(region.data())
+        ,m_pEnd(region.data() + region.size())
+        ,m_BlockSize(region.size())
+        ,m_pUpstream(pUpstream)
+    {}
+
+    ArenaBase(const ArenaBase&) = delete;
+    ArenaBase& operator=(const ArenaBase&) = delete;
+
+    ~ArenaBase() { Reset(); }
+
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t))
+    {
+        std::byte *p = align_up(m_pCur, alignment);
+        //aligning may step past the end of the block
+        if (p > m_pEnd || bytes > size_t(m_pEnd - p))
+        {
+            if (!m_pUpstream)
+                return nullptr;
+            chain_block(bytes + alignment);
+            p = align_up(m_pCur, alignment);
+        }
+        m_pCur = p + bytes;
+        return p;
+    }
+
+    //constructs a T in the arena, its destructor won't be called
+    template<class T, class... Args>
+    T* Create(Args&&... args)
+    {
+        void *p = allocate(sizeof(T), alignof(T));
+        return p ? new (p) T{std::forward<Args>(args)...} : nullptr;
+    }
+
+    template<class T>
+    std::span<T> CreateArray(size_t n)
+    {
+        void *p = allocate(sizeof(T) * n, alignof(T));
+        if (!p) return {};
+        return std::span<T>(new (p) T[n], n);
+    }
+
+    mark_t Mark() const { return {m_pBlock, m_pCur}; }
+
+    void Rewind(mark_t m)
+    {
+        while(m_pBlock != m.pBlock)
+        {
+            Block *pPrev = m_pBlock->pPrev;
+            m_pUpstream->deallocate(m_pBlock, m_pBlock->size, alignof(Block));
+            m_pBlock = pPrev;
+        }
+        m_pEnd = m_pBlock ? (std::byte*)m_pBlock + m_pBlock->size : m_pBase + m_BlockSize;
+        m_pCur = m.pCur;
+    }
+
+    void Reset() { Rewind({nullptr, m_pBase}); }
+
+    //rewinds to the current position when the returned object goes out of scope:
+    //  auto frame = arena.Scope();
+    auto Scope() { return ScopeExit([this, m = Mark()]{ Rewind(m); }); }
+
+    //bytes left in the current block
+    size_t Remaining() const { return m_pEnd - m_pCur; }
+
+private:
+    static std::byte* align_up(std::byte *p, size_t alignment)
+    {
+        return (std::byte*)((uintptr_t(p) + alignment - 1) & ~uintptr_t(alignment - 1));
+    }
+
+    void chain_block(size_t minBytes)
+    {
+        const size_t sz = std::max(m_BlockSize, minBytes + sizeof(Block));
+        //memory_resource::allocate never returns nullptr, it throws
+        void *pMem = m_pUpstream->allocate(sz, alignof(Block));
+        m_pBlock = new (pMem) Block{m_pBlock, sz};
+        m_pCur = (std::byte*)(m_pBlock + 1);
+        m_pEnd = (std::byte*)m_pBlock + sz;
+    }
+
+    std::byte *m_pBase;
+    std::byte *m_pCur;
+    std::byte *m_pEnd;
+    size_t m_BlockSize;
+    Block *m_pBlock = nullptr;//current chained block, nullptr: the initial region
+    std::pmr::memory_resource *m_pUpstream;
+};
+
+//arena with Sz bytes of inline storage, e.g. a per-request frame allocator:
+//  Arena<2048> g_Frame;
+//  void handle(Request const& r) { auto frame = g_Frame.Scope(); ... }
+template<size_t Sz>
+class Arena: public ArenaBase
+{
+public:
+    Arena(std::pmr::memory_resource *pUpstream = nullptr): ArenaBase(m_Storage, pUpstream) {}
+
+private:
+    alignas(std::max_align_t) std::byte m_Storage[Sz];
+};
+
+//std::pmr adapter, deallocate is a no-op:
+//  ArenaResource res(g_Frame);
+//  std::pmr::vector<int> v(&res);
+class ArenaResource: public std::pmr::memory_resource
+{
+public:
+    ArenaResource(ArenaBase &arena): m_Arena(arena) {}
+
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        if (void *p = m_Arena.allocate(bytes, alignment))
+            return p;
+        return std::pmr::null_memory_resource()->allocate(bytes, alignment);//reports std::bad_alloc
+    }
+
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override {}
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+
+private:
+    ArenaBase &m_Arena;
+};
+
+#endif
@@ -63,8 +63,9 @@ public:
         return end();
     }
 
-    template<class X, class M> requires requires(T& t) { *t; }//supports deref
-    iterator_t find(X const& r, M deref_t<T>::*pMem)
+    //U: deref_t<T> in the signature must not be formed for types that can't be dereferenced
+    template<class X, class M, class U = T> requires requires(U& t) { *t; }//supports deref
+    iterator_t find(X const& r, M deref_t<U>::*pMem)
     {
         for(auto i = begin(), e = end(); i != e; ++i)
         {
@@ -0,0 +1,301 @@
+#ifndef LIB_DEFERRED_LOG_HPP_
+#define LIB_DEFERRED_LOG_HPP_
+
+#include <atomic>
+#include <span>
+#include <tuple>
+#include "lib_formatter.hpp"
+
+#ifndef FMT_DEFERRED_LOG_SIZE
+#define FMT_DEFERRED_LOG_SIZE 4096
+#endif
+
+#ifndef FMT_DEFERRED_LOG_MAX_LINE
+#define FMT_DEFERRED_LOG_MAX_LINE 256
+#endif
+
+#ifndef DEFERRED_LOG_TIMESTAMP
+#if __has_include("esp_timer.h")
+#include "esp_timer.h"
+#define DEFERRED_LOG_TIMESTAMP() uint32_t(esp_timer_get_time())
+#else
+#include <chrono>
+#define DEFERRED_LOG_TIMESTAMP() uint32_t(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count())
+#endif
+#endif
+
+namespace tools
+{
+    //wrap-aware access to a power-of-2 sized byte ring
+    template<size_t N>
+    struct deferred_ring_io_t
+    {
+        static constexpr uint32_t kMask = N - 1;
+
+        std::byte *pBuf;
+        uint32_t pos;
+
+        void put(const void *pSrc, size_t sz)
+        {
+            const uint32_t off = pos & kMask;
+            const size_t first = std::min<size_t>(sz, N - off);
+            std::memcpy(pBuf + off, pSrc, first);
+            std::memcpy(pBuf, (const std::byte*)pSrc + first, sz - first);
+            pos += sz;
+        }
+
+        void get(void *pDst, size_t sz)
+        {
+            const uint32_t off = pos & kMask;
+            const size_t first = std::min<size_t>(sz, N - off);
+            std::memcpy(pDst, pBuf + off, first);
+            std::memcpy((std::byte*)pDst + first, pBuf, sz - first);
+            pos += sz;
+        }
+
+        void zero(size_t sz)
+        {
+            const uint32_t off = pos & kMask;
+            const size_t first = std::min<size_t>(sz, N - off);
+            std::memset(pBuf + off, 0, first);
+            std::memset(pBuf, 0, sz - first);
+            pos += sz;
+        }
+    };
+
+    //binary encoding of a single argument: trivially copyable values are stored as is.
+    //kFixedSize is the part of the encoding that can't be truncated,
+    //encode() takes what exceeds it from budget
+    template<class T>
+    struct deferred_arg_t
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Deferred log arguments must be trivially copyable or strings");
+        using decoded_t = T;
+        static constexpr size_t kFixedSize = sizeof(T);
+
+        static size_t size(T const&) { return sizeof(T); }
+
+        template<class W>
+        static void encode(W &w, T const& v, size_t &) { w.put(&v, sizeof(T)); }
+
+        static T decode(const std::byte *&p)
+        {
+            T v;
+            std::memcpy(&v, p, sizeof(T));
+            p += sizeof(T);
+            return v;
+        }
+    };
+
+    //strings are copied: the caller's buffer may be gone by the time the record is drained
+    template<>
+    struct deferred_arg_t<std::string_view>
+    {
+        using decoded_t = std::string_view;
+        static constexpr size_t kFixedSize = sizeof(uint16_t);
+
+        static size_t size(std::string_view const& v) { return sizeof(uint16_t) + std::min<size_t>(v.size(), 0xffff); }
+
+        template<class W>
+        static void encode(W &w, std::string_view const& v, size_t &budget)
+        {
+            uint16_t len = std::min<size_t>({v.size(), 0xffff, budget});
+            budget -= len;
+            w.put(&len, sizeof(len));
+            w.put(v.data(), len);
+        }
+
+        static std::string_view decode(const std::byte *&p)
+        {
+            uint16_t len;
+            std::memcpy(&len, p, sizeof(len));
+            std::string_view res((const char*)p + sizeof(len), len);
+            p += sizeof(len) + len;
+            return res;
+        }
+    };
+
+    template<>
+    struct deferred_arg_t<const char*>: deferred_arg_t<std::string_view>
+    {
+        static size_t size(const char *pStr) { return deferred_arg_t<std::string_view>::size(pStr); }
+
+        template<class W>
+        static void encode(W &w, const char *pStr, size_t &budget) { deferred_arg_t<std::string_view>::encode(w, pStr, budget); }
+    };
+
+    template<>
+    struct deferred_arg_t<char*>: deferred_arg_t<const char*> {};
+
+    //char and byte spans are copied as well, a pointer to the caller's buffer would dangle
+    template<class C, size_t E>
+    struct deferred_arg_t<std::span<C, E>>
+    {
+        using elem_t = std::remove_cv_t<C>;
+        static_assert(std::is_same_v<elem_t, char> || std::is_same_v<elem_t, uint8_t>, "Only char and byte spans can be deferred");
+        using decoded_t = std::span<const elem_t>;
+        static constexpr size_t kFixedSize = sizeof(uint16_t);
+
+        static size_t size(std::span<const elem_t> v) { return sizeof(uint16_t) + std::min<size_t>(v.size(), 0xffff); }
+
+        template<class W>
+        static void encode(W &w, std::span<const elem_t> v, size_t &budget)
+        {
+            uint16_t len = std::min<size_t>({v.size(), 0xffff, budget});
+            budget -= len;
+            w.put(&len, sizeof(len));
+            w.put(v.data(), len);
+        }
+
+        static decoded_t decode(const std::byte *&p)
+        {
+            uint16_t len;
+            std::memcpy(&len, p, sizeof(len));
+            decoded_t res((const elem_t*)(p + sizeof(len)), len);
+            p += sizeof(len) + len;
+            return res;
+        }
+    };
+
+    template<size_t N>
+    struct deferred_arg_t<uint8_t[N]>: deferred_arg_t<std::span<const uint8_t>> {};
+
+    //type an argument is encoded as: decayed, except byte arrays which are formatted as their content
+    template<class T>
+    struct deferred_arg_type { using type = std::decay_t<T>; };
+
+    template<size_t N>
+    struct deferred_arg_type<uint8_t[N]> { using type = uint8_t[N]; };
+
+    template<class T>
+    using deferred_arg_type_t = typename deferred_arg_type<T>::type;
+
+    //formats the binary encoded arguments of a record into pBuf, returns the length
+    using deferred_decode_fn_t = size_t(*)(char *pBuf, size_t n, const std::byte *pArgs);
+
+    template<fmt_literal_t S, class... Args>
+    size_t deferred_decode(char *pBuf, size_t n, const std::byte *pArgs)
+    {
+        //braced initialization guarantees left-to-right decoding
+        std::tuple<typename deferred_arg_t<Args>::decoded_t...> args{deferred_arg_t<Args>::decode(pArgs)...};
+        return std::apply([&](auto const&... a){
+                return format_to_silent(BufferFormatter(pBuf, n, false), compiled_fmt<S>, a...);
+            }, args);
+    }
+
+    //defmt-style deferred logging.
+    //write() only stores the decoder (which carries the format string), a timestamp and
+    //the binary encoded arguments into a lock-free multi-producer byte ring.
+    //String and span arguments are truncated (left to right) so that a record fits kMaxRecordSize.
+    //The actual text formatting happens in drain(), e.g. from a low-priority task:
+    //  g_DeferredLog.drain([](uint32_t ts, std::string_view line){ printf("%.*s", (int)line.size(), line.data()); });
+    template<size_t N>
+    class DeferredLog
+    {
+        static_assert(N >= 64 && (N & (N - 1)) == 0, "Deferred log size must be a power of 2");
+
+        using io_t = deferred_ring_io_t<N>;
+        static constexpr uint32_t kCommitted = 0x80000000;
+        //committed flag + size, timestamp, decoder
+        static constexpr size_t kHeaderSize = sizeof(uint32_t) * 2 + sizeof(deferred_decode_fn_t);
+    public:
+        static constexpr size_t kMaxRecordSize = std::min<size_t>(N / 4, 256);
+
+        //returns false if the record was dropped because the ring is full
+        template<fmt_literal_t S, class... Args>
+        bool write(compiled_format_t<S>, Args const&... args)
+        {
+            static_assert(compiled_format_t<S>::kArgs <= sizeof...(Args), "Not enough format arguments or invalid format argument number");
+            constexpr size_t kFixed = kHeaderSize + (deferred_arg_t<deferred_arg_type_t<Args>>::kFixedSize + ... + 0);
+            static_assert(kFixed <= kMaxRecordSize, "Deferred log arguments don't fit into a record");
+            const size_t payload = (deferred_arg_t<deferred_arg_type_t<Args>>::size(args) + ... + 0);
+            //bytes of string/span content that fit
+            size_t budget = kHeaderSize + payload - kFixed;
+            if (budget > kMaxRecordSize - kFixed)
+            {
+                budget = kMaxRecordSize - kFixed;
+                m_Truncated.fetch_add(1, std::memory_order_relaxed);
+            }
+            const uint32_t sz = (kFixed + budget + 3) & ~3u;
+
+            uint32_t pos = m_Reserve.load(std::memory_order_relaxed);
+            do
+            {
+                if (pos + sz - m_Read.load(std::memory_order_acquire) > N)
+                {
+                    m_Dropped.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+            }while(!m_Reserve.compare_exchange_weak(pos, pos + sz, std::memory_order_relaxed));
+
+            const uint32_t ts = DEFERRED_LOG_TIMESTAMP();
+            const deferred_decode_fn_t pDecode = &deferred_decode<S, deferred_arg_type_t<Args>...>;
+            io_t w{m_Buf, pos + uint32_t(sizeof(uint32_t))};
+            w.put(&ts, sizeof(ts));
+            w.put(&pDecode, sizeof(pDecode));
+            (deferred_arg_t<deferred_arg_type_t<Args>>::encode(w, args, budget), ...);
+
+            header_at(pos).store(sz | kCommitted, std::memory_order_release);
+            return true;
+        }
+
+        //single consumer. Formats one record and passes it to sink(uint32_t timestamp, std::string_view line)
+        //returns false if there is nothing (committed) to drain
+        template<class Sink>
+        bool drain_one(Sink &&sink)
+        {
+            const uint32_t pos = m_Read.load(std::memory_order_relaxed);
+            if (pos == m_Reserve.load(std::memory_order_acquire))
+                return false;
+            const uint32_t h = header_at(pos).load(std::memory_order_acquire);
+            if (!(h & kCommitted))
+                return false;//producer is still writing
+
+            const uint32_t sz = h & ~kCommitted;
+            alignas(uint32_t) std::byte rec[kMaxRecordSize];
+            io_t r{m_Buf, pos};
+            r.get(rec, sz);
+            //stale bytes could look like a committed header to a future read
+            io_t{m_Buf, pos}.zero(sz);
+            m_Read.store(pos + sz, std::memory_order_release);
+
+            uint32_t ts;
+            deferred_decode_fn_t pDecode;
+            std::memcpy(&ts, rec + sizeof(uint32_t), sizeof(ts));
+            std::memcpy(&pDecode, rec + sizeof(uint32_t) * 2, sizeof(pDecode));
+            char line[FMT_DEFERRED_LOG_MAX_LINE];
+            //the decoder returns the untruncated length
+            const size_t len = std::min(pDecode(line, sizeof(line), rec + kHeaderSize), sizeof(line));
+            sink(ts, std::string_view(line, len));
+            return true;
+        }
+
+        template<class Sink>
+        size_t drain(Sink &&sink)
+        {
+            size_t n = 0;
+            while(drain_one(sink))
+                ++n;
+            return n;
+        }
+
+        uint32_t dropped() const { return m_Dropped.load(std::memory_order_relaxed); }
+        uint32_t truncated() const { return m_Truncated.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic_ref<uint32_t> header_at(uint32_t pos)
+        {
+            return std::atomic_ref<uint32_t>(*(uint32_t*)(m_Buf + (pos & io_t::kMask)));
+        }
+
+        alignas(uint32_t) std::byte m_Buf[N] = {};
+        std::atomic<uint32_t> m_Reserve{0};
+        std::atomic<uint32_t> m_Read{0};
+        std::atomic<uint32_t> m_Dropped{0};
+        std::atomic<uint32_t> m_Truncated{0};
+    };
+
+    inline DeferredLog<FMT_DEFERRED_LOG_SIZE> g_DeferredLog;
+}
+
+#endif
@@ -28,7 +28,7 @@ struct tools::formatter_t<Err>
     template<FormatDestination Dest>
     static std::expected<size_t, FormatError> format_to(Dest &&dst, std::string_view const& fmtStr, Err const& e)
     {
-        return tools::format_to(std::forward<Dest>(dst), "::Err\\{at {}: {}}", e.pLocation, esp_err_to_name(e.code));
+        return tools::format_to(std::forward<Dest>(dst), tools::compiled_fmt<"::Err\\{at {}: {}}">, e.pLocation, esp_err_to_name(e.code));
     }
 };
 
@@ -4,7 +4,13 @@
 #include <span>
 #include <expected>
 #include <cstring>
-#include <span>
+#include <cstdint>
+#include <concepts>
+#include <algorithm>
+#include <tuple>
+#include <utility>
+#include <bit>
+#include <cmath>
 
 namespace tools
 {
@@ -41,6 +47,153 @@ namespace tools
         100000000,
     };
 
+    static inline constexpr uint64_t g_DecimalFactors64[] = {
+        1ull,
+        10ull,
+        100ull,
+        1000ull,
+        10000ull,
+        100000ull,
+        1000000ull,
+        10000000ull,
+        100000000ull,
+        1000000000ull,
+        10000000000ull,
+        100000000000ull,
+        1000000000000ull,
+        10000000000000ull,
+        100000000000000ull,
+        1000000000000000ull,
+        10000000000000000ull,
+        100000000000000000ull,
+        1000000000000000000ull,
+        10000000000000000000ull,
+    };
+
+    static inline constexpr char g_DecimalDigitPairs[] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+
+    static inline constexpr char g_HexDigitsLower[] = "0123456789abcdef";
+    static inline constexpr char g_HexDigitsUpper[] = "0123456789ABCDEF";
+
+    //[[fill]align][#][0][width][.precision][type]
+    //width is limited to kMaxWidth: a wider one fails to compile with compiled_fmt
+    //and makes format_to return FormatError::InvalidFormatString at runtime
+    struct format_spec_t
+    {
+        static constexpr uint8_t kMaxWidth = 64;
+
+        char fill = ' ';
+        char align = 0;//'<', '>', '^' or 0 for the type's default
+        char type = 0;
+        bool alt = false;//'#'
+        bool zeroPad = false;
+        uint8_t width = 0;//clamped to kMaxWidth
+        int8_t precision = -1;
+        bool tooWide = false;//width above kMaxWidth was requested
+
+        constexpr static bool is_align(char c) { return c == '<' || c == '>' || c == '^'; }
+        constexpr static bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+        constexpr static format_spec_t parse(std::string_view f)
+        {
+            format_spec_t r;
+            size_t i = 0, n = f.size();
+            if (n >= 2 && is_align(f[1]))
+            {
+                r.fill = f[0];
+                r.align = f[1];
+                i = 2;
+            }else if (n >= 1 && is_align(f[0]))
+            {
+                r.align = f[0];
+                i = 1;
+            }
+            if (i < n && f[i] == '#') { r.alt = true; ++i; }
+            if (i < n && f[i] == '0') { r.zeroPad = true; ++i; }
+            size_t w = 0;
+            for(; i < n && is_digit(f[i]); ++i)
+                w = std::min<size_t>(w * 10 + (f[i] - '0'), kMaxWidth + 1);
+            r.tooWide = w > kMaxWidth;
+            r.width = uint8_t(std::min<size_t>(w, kMaxWidth));
+            if (i < n && f[i] == '.')
+            {
+                size_t p = 0;
+                for(++i; i < n && is_digit(f[i]); ++i)
+                    p = std::min<size_t>(p * 10 + (f[i] - '0'), 127);
+                r.precision = int8_t(p);
+            }
+            if (i < n)
+                r.type = f[i];
+            return r;
+        }
+    };
+
+    template<std::unsigned_integral U>
+    constexpr uint8_t decimal_digits_count(U v)
+    {
+        //1233/4096 ~ log10(2): estimate from the bit width, then correct by one table lookup
+        //(v | 1) has the same amount of digits as v but is never 0
+        v |= 1;
+        uint32_t t = (uint32_t(std::bit_width(v)) * 1233) >> 12;
+        return uint8_t(t - (uint64_t(v) < g_DecimalFactors64[t]) + 1);
+    }
+
+    constexpr uint8_t hex_digits_count(uint64_t v)
+    {
+        return v ? uint8_t((std::bit_width(v) + 3) / 4) : 1;
+    }
+
+    //writes the digits of v backwards ending right before pEnd, two at a time
+    constexpr char* write_decimal_digits(char *pEnd, uint32_t v)
+    {
+        while(v >= 100)
+        {
+            const char *pPair = g_DecimalDigitPairs + (v % 100) * 2;
+            v /= 100;
+            *--pEnd = pPair[1];
+            *--pEnd = pPair[0];
+        }
+        if (v >= 10)
+        {
+            *--pEnd = g_DecimalDigitPairs[v * 2 + 1];
+            *--pEnd = g_DecimalDigitPairs[v * 2];
+        }else
+            *--pEnd = char('0' + v);
+        return pEnd;
+    }
+
+    constexpr char* write_decimal_digits(char *pEnd, uint64_t v)
+    {
+        //peel off 8 digits at a time so that the bulk of the work is 32-bit arithmetic
+        while(v > 0xffffffff)
+        {
+            uint32_t lo = uint32_t(v % 100000000);
+            v /= 100000000;
+            char *pLoEnd = pEnd;
+            pEnd = write_decimal_digits(pEnd, lo);
+            while(pEnd > pLoEnd - 8)
+                *--pEnd = '0';
+        }
+        return write_decimal_digits(pEnd, uint32_t(v));
+    }
+
+    constexpr char* write_hex_digits(char *pEnd, uint64_t v, uint8_t n, const char *pDigits)
+    {
+        for(uint8_t i = 0; i < n; ++i, v >>= 4)
+            *--pEnd = pDigits[v & 0x0f];
+        return pEnd;
+    }
+
     template<class T>
     struct formatter_t
     {
@@ -70,6 +223,68 @@ namespace tools
     };
 
 
+    //value = mantissa * 10^exponent
+    struct decimal_fp32_t
+    {
+        uint32_t mantissa;
+        int32_t exponent;
+    };
+
+    //shortest decimal that round-trips to the same float (finite, non-zero input)
+    decimal_fp32_t float_to_decimal(uint32_t ieeeMantissa, uint32_t ieeeExponent);
+
+    static constexpr int32_t kFloatPosExp10Threshold = 7;//1e7 and above are printed with an exponent
+    static constexpr int32_t kFloatNegExp10Threshold = -5;//so are values below 1e-4
+    static constexpr int32_t kFloatMaxPrecision = 16;
+    static constexpr size_t kFloatBufSize = 32;
+
+    //renders v into pBuf (at least kFloatBufSize) honoring spec.precision, returns the length
+    size_t format_float_to_buf(char *pBuf, float v, format_spec_t const& spec);
+
+    //float stays in 32-bit integer arithmetic: no double emulation on single-precision FPUs
+    //{} - shortest representation that round-trips
+    //{:.3} - 3 decimal places, rounded from the shortest representation (digits beyond it are 0)
+    //width/fill/align are supported as for integers
+    template<>
+    struct formatter_t<float>
+    {
+        template<FormatDestination Dest>
+        static std::expected<size_t, FormatError> format_to(Dest &&dst, std::string_view const& fmtStr, float v)
+        {
+            format_spec_t spec;
+            if (!fmtStr.empty())
+            {
+                spec = format_spec_t::parse(fmtStr);
+                if (spec.tooWide)
+                    return std::unexpected(FormatError::InvalidFormatString);
+            }
+
+            char t[format_spec_t::kMaxWidth + kFloatBufSize];
+            size_t len = format_float_to_buf(t, v, spec);
+            if (spec.width > len)
+            {
+                const size_t pad = spec.width - len;
+                if (spec.zeroPad && !spec.align && std::isfinite(v))
+                {
+                    const size_t sign = t[0] == '-';
+                    std::memmove(t + sign + pad, t + sign, len - sign);
+                    std::memset(t + sign, '0', pad);
+                }else if (spec.align == '<')
+                    std::memset(t + len, spec.fill, pad);
+                else
+                {
+                    const size_t lpad = spec.align == '^' ? pad / 2 : pad;
+                    std::memmove(t + lpad, t, len);
+                    std::memset(t, spec.fill, lpad);
+                    std::memset(t + lpad + len, spec.fill, pad - lpad);
+                }
+                len = spec.width;
+            }
+            dst(std::string_view(t, len));
+            return len;
+        }
+    };
+
     template<std::floating_point T>
     struct formatter_t<T>
     {
@@ -273,28 +488,99 @@ namespace tools
         }
     };
 
+    //byte spans:
+    //{}    - "01 ab ff " (every byte followed by a space)
+    //{:n}  - "01abff" (packed)
+    //{:d}  - hexdump rows: "00000000  01 ab ff ...\n", 16 bytes per row, extra space after 8
+    //{:da} - same with an ascii column: "...  |..A.|"
+    //'X' anywhere in the spec switches to upper case
+    struct bytes_format_spec_t
+    {
+        bool upper = false;
+        bool packed = false;
+        bool dump = false;
+        bool ascii = false;
+
+        constexpr static bytes_format_spec_t parse(std::string_view f)
+        {
+            bytes_format_spec_t r;
+            for(char c : f)
+            {
+                switch(c)
+                {
+                    case 'X': r.upper = true; break;
+                    case 'n': r.packed = true; break;
+                    case 'd': r.dump = true; break;
+                    case 'a': r.dump = r.ascii = true; break;
+                }
+            }
+            return r;
+        }
+    };
+
+    static constexpr size_t kHexDumpBytesPerRow = 16;
+    static constexpr size_t kHexBlockSize = 96;//big enough for a hexdump row and for a chunk of hex
+
+    //encodes up to kHexBlockSize/3 (spaced) or kHexBlockSize/2 (packed) bytes into pDst, 4 bytes per step
+    size_t hex_encode_block(char *pDst, const uint8_t *pSrc, size_t n, bytes_format_spec_t const& spec);
+    //renders a single hexdump row of n <= kHexDumpBytesPerRow bytes into pDst (at least kHexBlockSize)
+    size_t hexdump_row(char *pDst, const uint8_t *pSrc, size_t n, size_t offset, bytes_format_spec_t const& spec);
+
+    constexpr size_t formatted_bytes_size(std::string_view const& fmtStr, size_t n)
+    {
+        const auto spec = bytes_format_spec_t::parse(fmtStr);
+        if (!spec.dump)
+            return n * (spec.packed ? 2 : 3);
+
+        //offset + 2 spaces, hex column, optional |ascii|, newline
+        auto row = [&](size_t c) -> size_t {
+            if (spec.ascii)
+                return 10 + kHexDumpBytesPerRow * 3 + 2 + c + 2 + 1;
+            return 10 + c * 3 + (c > kHexDumpBytesPerRow / 2) + 1;
+        };
+        const size_t full = n / kHexDumpBytesPerRow;
+        const size_t rest = n % kHexDumpBytesPerRow;
+        return full * row(kHexDumpBytesPerRow) + (rest ? row(rest) : 0);
+    }
+
+    //emits the bytes in blocks: one destination call per chunk or hexdump row
+    template<FormatDestination Dest>
+    std::expected<size_t, FormatError> format_bytes_to(Dest &&dst, std::string_view const& fmtStr, std::span<const uint8_t> v)
+    {
+        const auto spec = bytes_format_spec_t::parse(fmtStr);
+        char blk[kHexBlockSize];
+        size_t res = 0;
+        if (spec.dump)
+        {
+            for(size_t off = 0; off < v.size(); off += kHexDumpBytesPerRow)
+            {
+                size_t len = hexdump_row(blk, v.data() + off, std::min(kHexDumpBytesPerRow, v.size() - off), off, spec);
+                dst(std::string_view(blk, len));
+                res += len;
+            }
+            return res;
+        }
+
+        const size_t chunk = spec.packed ? kHexBlockSize / 2 : kHexBlockSize / 3;
+        for(size_t off = 0; off < v.size(); off += chunk)
+        {
+            size_t len = hex_encode_block(blk, v.data() + off, std::min(chunk, v.size() - off), spec);
+            dst(std::string_view(blk, len));
+            res += len;
+        }
+        return res;
+    }
+
     template<size_t N>
     struct formatter_t<uint8_t[N]>
     {
         template<FormatDestination Dest>
         static std::expected<size_t, FormatError> format_to(Dest &&dst, std::string_view const& fmtStr, const uint8_t(&v)[N])
         {
-            for(uint8_t b : v)
-            {
-                uint8_t hi = (b >> 4) & 0xf;
-                uint8_t lo = b & 0xf;
-                if (hi < 10)
-                    dst('0' + hi);
-                else
-                    dst('a' + hi - 10);
-                if (lo < 10)
-                    dst('0' + lo);
-                else
-                    dst('a' + lo - 10);
-                dst(' ');
-            }
-            return N * 3;
+            return format_bytes_to(std::forward<Dest>(dst), fmtStr, std::span<const uint8_t>(v));
         }
+
+        static size_t formatted_size(std::string_view const& fmtStr, const uint8_t(&v)[N]) { return formatted_bytes_size(fmtStr, N); }
     };
 
     template<>
@@ -306,6 +592,8 @@ namespace tools
             dst(std::string_view{v.begin(), v.end()});
             return v.size();
         }
+
+        static size_t formatted_size(std::string_view const& fmtStr, std::span<char> const &v) { return v.size(); }
     };
 
     template<>
@@ -317,6 +605,8 @@ namespace tools
             dst(std::string_view{v.begin(), v.end()});
             return v.size();
         }
+
+        static size_t formatted_size(std::string_view const& fmtStr, std::span<const char> const &v) { return v.size(); }
     };
 
     template<>
@@ -325,22 +615,10 @@ namespace tools
         template<FormatDestination Dest>
         static std::expected<size_t, FormatError> format_to(Dest &&dst, std::string_view const& fmtStr, std::span<uint8_t> const &v)
         {
-            for(uint8_t b : v)
-            {
-                uint8_t hi = (b >> 4) & 0x0f;
-                uint8_t lo = b & 0x0f;
-                if (hi < 10)
-                    dst('0' + hi);
-                else
-                    dst('a' + hi - 10);
-                if (lo < 10)
-                    dst('0' + lo);
-                else
-                    dst('a' + lo - 10);
-                dst(' ');
-            }
-            return v.size() * 3;
+            return format_bytes_to(std::forward<Dest>(dst), fmtStr, std::span<const uint8_t>(v));
         }
+
+        static size_t formatted_size(std::string_view const& fmtStr, std::span<uint8_t> const &v) { return formatted_bytes_size(fmtStr, v.size()); }
     };
 
     template<>
@@ -349,86 +627,160 @@ namespace tools
         template<FormatDestination Dest>
         static std::expected<size_t, FormatError> format_to(Dest &&dst, std::string_view const& fmtStr, std::span<const uint8_t> const &v)
         {
-            for(uint8_t b : v)
-            {
-                uint8_t hi = (b >> 4) & 0x0f;
-                uint8_t lo = b & 0x0f;
-                if (hi < 10)
-                    dst('0' + hi);
-                else
-                    dst('a' + hi - 10);
-                if (lo < 10)
-                    dst('0' + lo);
-                else
-                    dst('a' + lo - 10);
-                dst(' ');
-            }
-            return v.size() * 3;
+            return format_bytes_to(std::forward<Dest>(dst), fmtStr, std::span<const uint8_t>(v));
         }
+
+        static size_t formatted_size(std::string_view const& fmtStr, std::span<const uint8_t> const &v) { return formatted_bytes_size(fmtStr, v.size()); }
     };
 
     template<std::integral T>
     struct formatter_t<T>
     {
-        template<FormatDestination Dest>
-        static std::expected<size_t, FormatError> format_to(Dest &&dst, std::string_view const& fmtStr, T v)
+        using U = std::make_unsigned_t<T>;
+        using WideU = std::conditional_t<(sizeof(T) > sizeof(uint32_t)), uint64_t, uint32_t>;
+
+        struct layout_t
+        {
+            format_spec_t spec;
+            std::string_view prefix;
+            const char *pHexDigits = g_HexDigitsUpper;
+            WideU u;
+            uint8_t digits;
+            bool hex = false;
+
+            size_t body() const { return prefix.size() + digits; }
+            size_t size() const { return std::max<size_t>(spec.width, body()); }
+        };
+
+        //{} and {:8}/{:08}/{:<8}/{:*^8} - decimal
+        //{:x}/{:X} - all nibbles with '0x' prefix
+        //{:8x}/{:>8X}/{:#08x} - minimal amount of nibbles padded to width, '#' adds '0x' prefix
+        static layout_t make_layout(std::string_view const& fmtStr, T v)
         {
+            layout_t l;
             if (!fmtStr.empty())
             {
-                constexpr T mask = 0x0f;
-                constexpr const uint8_t n = sizeof(T) * 2;
-                if (fmtStr[0] == 'x')
+                l.spec = format_spec_t::parse(fmtStr);
+                if (l.spec.type && l.spec.type != 'd')
                 {
-                    dst("0x");
-                    for(uint8_t i = 0; i < n; ++i)
-                    {
-                        uint8_t digit = (v >> (n - i - 1) * 4) & mask;
-                        char c = digit < 10 ? ('0' + digit) : ('a' + digit - 10);
-                        dst(c);
-                    }
-                }else
-                {
-                    dst("0x");
-                    for(uint8_t i = 0; i < n; ++i)
-                    {
-                        uint8_t digit = (v >> (n - i - 1) * 4) & mask;
-                        char c = digit < 10 ? ('0' + digit) : ('A' + digit - 10);
-                        dst(c);
-                    }
+                    l.hex = true;
+                    if (l.spec.type == 'x')
+                        l.pHexDigits = g_HexDigitsLower;
+                    if (!l.spec.width)
+                        l.spec.alt = true;
                 }
-                return n + 2;
             }
-            bool neg;
-            if constexpr (std::is_signed_v<T>)
+
+            if (l.hex)
             {
-                neg = v < 0;
-                if (neg)
-                    v = -v;
+                l.u = WideU(U(v));
+                if (l.spec.alt)
+                    l.prefix = "0x";
+                l.digits = l.spec.width ? hex_digits_count(l.u) : sizeof(T) * 2;
             }else
-                neg = false;
+            {
+                if constexpr (std::is_signed_v<T>)
+                {
+                    if (v < 0)
+                    {
+                        l.prefix = "-";
+                        l.u = WideU(U(U(0) - U(v)));
+                    }else
+                        l.u = WideU(v);
+                }else
+                    l.u = WideU(v);
+                l.digits = decimal_digits_count(l.u);
+            }
+            return l;
+        }
 
-            char t[16];
-            constexpr uint8_t n = std::size(t);
-            t[15] = '0';
-            uint8_t d = v == 0 ? 1 : 0;
+        static size_t formatted_size(std::string_view const& fmtStr, T v) { return make_layout(fmtStr, v).size(); }
 
-            while(v)
+        template<FormatDestination Dest>
+        static std::expected<size_t, FormatError> format_to(Dest &&dst, std::string_view const& fmtStr, T v)
+        {
+            if (fmtStr.empty())
             {
-                t[n - ++d] = '0' + (v % 10);
-                v /= 10;
+                //plain decimal: digits are written backwards, no layout needed
+                char t[24];
+                char *pEnd = t + sizeof(t);
+                char *p;
+                if constexpr (std::is_signed_v<T>)
+                {
+                    if (v < 0)
+                    {
+                        p = write_decimal_digits(pEnd, WideU(U(U(0) - U(v))));
+                        *--p = '-';
+                    }else
+                        p = write_decimal_digits(pEnd, WideU(v));
+                }else
+                    p = write_decimal_digits(pEnd, WideU(v));
+                dst(std::string_view(p, pEnd - p));
+                return pEnd - p;
             }
-
-            if constexpr (std::is_signed_v<T>)
+            if (fmtStr.size() == 1 && (fmtStr[0] == 'x' || fmtStr[0] == 'X'))
             {
-                if (neg)
-                    t[n - ++d] = '-';
+                //all nibbles with '0x' prefix: fixed size
+                constexpr uint8_t n = sizeof(T) * 2;
+                char t[n + 2] = {'0', 'x'};
+                write_hex_digits(t + n + 2, WideU(U(v)), n, fmtStr[0] == 'x' ? g_HexDigitsLower : g_HexDigitsUpper);
+                dst(std::string_view(t, n + 2));
+                return n + 2;
             }
 
-            dst(std::string_view(t + n - d, d));
-            return d;
+            const layout_t l = make_layout(fmtStr, v);
+            if (l.spec.tooWide)
+                return std::unexpected(FormatError::InvalidFormatString);
+            auto const& spec = l.spec;
+            const auto digits = l.digits;
+            const auto prefix = l.prefix;
+            const size_t body = l.body();
+            char t[format_spec_t::kMaxWidth];
+            const size_t pad = spec.width > body ? spec.width - body : 0;
+            size_t lpad = 0, zeros = 0, rpad = 0;
+            if (spec.zeroPad && !spec.align)
+                zeros = pad;
+            else if (spec.align == '<')
+                rpad = pad;
+            else if (spec.align == '^')
+            {
+                lpad = pad / 2;
+                rpad = pad - lpad;
+            }else
+                lpad = pad;
+
+            char *p = t;
+            std::memset(p, spec.fill, lpad);
+            p += lpad;
+            if (!prefix.empty())
+                std::memcpy(p, prefix.data(), prefix.size());
+            p += prefix.size();
+            std::memset(p, '0', zeros);
+            p += zeros + digits;
+            if (l.hex)
+                write_hex_digits(p, l.u, digits, l.pHexDigits);
+            else
+                write_decimal_digits(p, l.u);
+            std::memset(p, spec.fill, rpad);
+            p += rpad;
+
+            dst(std::string_view(t, p - t));
+            return p - t;
         }
     };
 
+    template<>
+    struct formatter_t<bool>
+    {
+        template<FormatDestination Dest>
+        static std::expected<size_t, FormatError> format_to(Dest &&dst, std::string_view const& fmtStr, bool v)
+        {
+            return formatter_t<uint8_t>::format_to(std::forward<Dest>(dst), fmtStr, uint8_t(v));
+        }
+
+        static size_t formatted_size(std::string_view const& fmtStr, bool v) { return formatter_t<uint8_t>::formatted_size(fmtStr, uint8_t(v)); }
+    };
+
     template<class T> requires (std::is_enum_v<T>)
     struct formatter_t<T>
     {
@@ -437,6 +789,11 @@ namespace tools
         {
             return formatter_t<std::underlying_type_t<T>>::format_to(std::forward<Dest>(dst), fmtStr, std::underlying_type_t<T>(v));
         }
+
+        static size_t formatted_size(std::string_view const& fmtStr, T const&v)
+        {
+            return formatter_t<std::underlying_type_t<T>>::formatted_size(fmtStr, std::underlying_type_t<T>(v));
+        }
     };
 
     template<class T>
@@ -447,6 +804,8 @@ namespace tools
         {
             return formatter_t<size_t>::format_to(std::forward<Dest>(dst), fmtStr, std::size_t(v));
         }
+
+        static size_t formatted_size(std::string_view const& fmtStr, T *v) { return formatter_t<size_t>::formatted_size(fmtStr, std::size_t(v)); }
     };
 
     template<class Value, class Error>
@@ -468,7 +827,7 @@ namespace tools
                 auto r = formatter_t<Error>::format_to(std::forward<Dest>(dst), fmtStr, v.error());
                 if (!r)
                     return r;
-                return *r + 4; 
+                return *r + 2;
             }
         }
     };
@@ -478,6 +837,7 @@ namespace tools
     {
         template<FormatDestination Dest>
         static std::expected<size_t, FormatError> format_to(Dest &&dst, std::string_view const& fmtStr, char c) { dst(c); return 1; }
+        static size_t formatted_size(std::string_view const& fmtStr, char c) { return 1; }
     };
 
     template<>
@@ -485,6 +845,7 @@ namespace tools
     {
         template<FormatDestination Dest>
         static std::expected<size_t, FormatError> format_to(Dest &&dst, std::string_view const& fmtStr, const char *pStr) { dst(pStr); return strlen(pStr); }
+        static size_t formatted_size(std::string_view const& fmtStr, const char *pStr) { return strlen(pStr); }
     };
 
     template<>
@@ -492,171 +853,321 @@ namespace tools
     {
         template<FormatDestination Dest>
         static std::expected<size_t, FormatError> format_to(Dest &&dst, std::string_view const& fmtStr, std::string_view const& sv) { dst(sv); return sv.size(); }
+        static size_t formatted_size(std::string_view const& fmtStr, std::string_view const& sv) { return sv.size(); }
     };
 
-    template<size_t I, FormatDestination Dest, class T, class... Rest>
-    std::expected<size_t, FormatError> format_nth_arg(size_t i, std::string_view const& fmtStr, Dest &&dst, T &&arg, Rest &&...args)
+    //FormatDestination that only counts
+    struct CountingFormatter
     {
-        //error checking?
-        if (I == i)
-            return formatter_t<std::remove_cvref_t<T>>::format_to(std::forward<Dest>(dst), fmtStr, std::forward<T>(arg));
+        size_t count = 0;
 
-        if constexpr (sizeof...(Rest) > 0)
-            return format_nth_arg<I+1>(i, fmtStr, std::forward<Dest>(dst), std::forward<Rest>(args)...);
-        else
-            return std::unexpected(FormatError::NotEnoughFormatArguments);
-    }
+        void operator()(char c) { ++count; }
+        void operator()(std::string_view const& sv) { count += sv.size(); }
+        void operator()(const char* pStr) { count += strlen(pStr); }
+        void operator()() {}
+    };
 
-    template<FormatDestination Dest, class... Args>
-    std::expected<size_t, FormatError> format_to(Dest &&dst, std::string_view f, Args &&...args)
+    //formatter_t<T> knows its output length without rendering
+    template<class T>
+    concept SizeFormattable = requires(std::string_view const& fmtStr, T const& v)
     {
-        size_t res = 0;
-        std::string_view::const_iterator pBegin = f.begin();
-        char prev = 0;
-        size_t arg = 0;
-        auto  e = f.end();
-        auto b = f.begin();
-        while(b != e)
+        { formatter_t<T>::formatted_size(fmtStr, v) } -> std::convertible_to<size_t>;
+    };
+
+    //formats a single argument, skipping rendering altogether when only counting
+    template<FormatDestination Dest, class T>
+    std::expected<size_t, FormatError> format_arg_to(Dest &&dst, std::string_view const& fmtStr, T &&arg)
+    {
+        using V = std::remove_cvref_t<T>;
+        if constexpr (std::is_same_v<std::remove_cvref_t<Dest>, CountingFormatter> && SizeFormattable<V>)
         {
-            char c = *b;
-            if (c == '{')
-            {
-                if (prev == '\\')
-                {
-                    auto sv = std::string_view(pBegin, b - 1);
-                    dst(sv);
-                    res += sv.size();
-                    pBegin = b;
-                }
-                else
-                {
-                    res += b - pBegin;
-                    dst(std::string_view(pBegin, b++));
-                    //parse format argument
-                    bool explicitNumber;
-                    size_t targ;
-                    if (*b >= '0' && *b <='9')
-                    {
-                        explicitNumber = true;
-                        targ = 0;
-                        do
-                        {
-                            targ = (targ * 10) + (*b++ - '0');
-                        }
-                        while(*b >= '0' && *b <='9');
-                    }else
-                    {
-                        targ = arg++;
-                        explicitNumber = false;
-                    }
+            size_t n = formatter_t<V>::formatted_size(fmtStr, arg);
+            dst.count += n;
+            return n;
+        }else
+            return formatter_t<V>::format_to(std::forward<Dest>(dst), fmtStr, std::forward<T>(arg));
+    }
 
+    //type-erased reference to any FormatDestination.
+    //formatter_t<T>::format_to<FormatSinkRef&> is instantiated once per T, not per (Dest, T)
+    class FormatSinkRef
+    {
+        struct VTable
+        {
+            void (*m_Char)(void*, char);
+            void (*m_Str)(void*, std::string_view);
+            void (*m_End)(void*);
+        };
 
-                    if (targ < sizeof...(args))
-                    {
-                        if (*b == ':') ++b;
-                        auto pFmtBegin = b;
-                        while(*b && *b != '}')
-                            ++b;
-                        if (*b != '}')
-                            return std::unexpected(FormatError::InvalidFormatString);
-                        std::string_view fmtStr(pFmtBegin, b++);
-                        if (auto r = format_nth_arg<0>(targ, fmtStr, std::forward<Dest>(dst), std::forward<Args>(args)...); !r)
-                            return r;
-                        else
-                            res += *r;
-                        pBegin = b;
-                    }
-                    else
-                        return std::unexpected{explicitNumber ? FormatError::InvalidFormatArgumentNumber : FormatError::NotEnoughFormatArguments};
-                }
-            }
-            prev = *b++;
+        template<class Dest>
+        static constexpr VTable v_Sink = {
+            /*char*/[](void *pDst, char c){ (*(Dest*)pDst)(c); },
+            /*str*/ [](void *pDst, std::string_view sv){ (*(Dest*)pDst)(sv); },
+            /*end*/ [](void *pDst){ (*(Dest*)pDst)(); },
+        };
+    public:
+        template<FormatDestination Dest> requires (!std::is_same_v<std::remove_cvref_t<Dest>, FormatSinkRef>)
+        FormatSinkRef(Dest &dst):
+            m_pDst((void*)&dst)
+            ,m_pTable(&v_Sink<std::remove_cvref_t<Dest>>)
+        {
+            if constexpr (std::is_same_v<std::remove_cvref_t<Dest>, CountingFormatter>)
+                m_pCounter = &dst;
         }
-        if (pBegin != e)
+
+        void operator()(char c) { m_pTable->m_Char(m_pDst, c); }
+        void operator()(std::string_view const& sv) { m_pTable->m_Str(m_pDst, sv); }
+        void operator()(const char* pStr) { m_pTable->m_Str(m_pDst, std::string_view(pStr)); }
+        void operator()() { m_pTable->m_End(m_pDst); }
+
+        //non-null when only the size is of interest
+        CountingFormatter* counter() const { return m_pCounter; }
+    private:
+        void *m_pDst;
+        const VTable *m_pTable;
+        CountingFormatter *m_pCounter = nullptr;
+    };
+
+    //type-erased argument: a pointer to the value and its formatter
+    struct format_arg_t
+    {
+        using Format = std::expected<size_t, FormatError>(*)(FormatSinkRef &dst, std::string_view const& fmtStr, const void *pArg);
+
+        const void *pArg;
+        Format pFormat;
+    };
+
+    template<class T>
+    std::expected<size_t, FormatError> format_erased_arg(FormatSinkRef &dst, std::string_view const& fmtStr, const void *pArg)
+    {
+        T const& v = *(const T*)pArg;
+        if constexpr (SizeFormattable<T>)
         {
-            dst(std::string_view(pBegin, e));
-            res += e - pBegin;
+            if (auto *pCounter = dst.counter())
+            {
+                size_t n = formatter_t<T>::formatted_size(fmtStr, v);
+                pCounter->count += n;
+                return n;
+            }
         }
-        dst();
-        return res;
+        return formatter_t<T>::format_to(dst, fmtStr, v);
+    }
+
+    template<class T>
+    format_arg_t make_format_arg(T const& v) { return {(const void*)&v, &format_erased_arg<T>}; }
+
+    //the one non-template parse/emit loop behind the runtime format_to overloads
+    std::expected<size_t, FormatError> vformat_to(FormatSinkRef dst, std::string_view f, std::span<const format_arg_t> args);
+
+    template<FormatDestination Dest, class... Args>
+    std::expected<size_t, FormatError> format_to(Dest &&dst, std::string_view f, Args &&...args)
+    {
+        const format_arg_t erased[sizeof...(Args) + 1] = {make_format_arg<std::remove_cvref_t<Args>>(args)..., {}};
+        return vformat_to(FormatSinkRef(dst), f, std::span<const format_arg_t>(erased, sizeof...(Args)));
     }
 
     template<FormatDestination Dest, class... Args>
     std::expected<size_t, FormatError> format_to(Dest &&dst, const char *pStr, Args &&...args)
     {
-        size_t res = 0;
-        auto pBegin = pStr;
-        char prev = 0, c;
+        return format_to(std::forward<Dest>(dst), std::string_view(pStr), std::forward<Args>(args)...);
+    }
+
+    /**********************************************************************/
+    /* Compile-time parsed format strings                                 */
+    /**********************************************************************/
+    //format string literal captured as a non-type template parameter
+    template<size_t N>
+    struct fmt_literal_t
+    {
+        consteval fmt_literal_t(const char (&s)[N]) { std::copy_n(s, N, str); }
+        consteval std::string_view view() const { return {str, N - 1}; }
+
+        char str[N];
+    };
+
+    struct fmt_segment_t
+    {
+        static constexpr uint8_t kLiteral = 0xff;
+
+        uint16_t offset;//into the parsed text
+        uint16_t len;
+        uint8_t arg;//argument index or kLiteral
+    };
+
+    //not constexpr on purpose: reaching any of these during constant evaluation fails the build
+    inline void format_string_error_unterminated_placeholder() {}
+    inline void format_string_error_too_long() {}
+    inline void format_string_error_too_many_arguments() {}
+
+    //parses the format string exactly like the runtime format_to does.
+    //With null pText/pSegs only the sizes are computed.
+    struct fmt_parse_sizes_t
+    {
+        size_t text = 0;
+        size_t segments = 0;
+        size_t args = 0;//minimal amount of arguments required
+    };
+
+    constexpr fmt_parse_sizes_t parse_format_string(std::string_view f, char *pText, fmt_segment_t *pSegs)
+    {
+        fmt_parse_sizes_t r;
+        size_t litBegin = 0;
         size_t arg = 0;
-        while((c = *pStr))
+        char prev = 0;
+        auto put = [&](char c){ if (pText) pText[r.text] = c; ++r.text; };
+        auto flush = [&]{
+            if (r.text != litBegin)
+            {
+                if (pSegs) pSegs[r.segments] = {uint16_t(litBegin), uint16_t(r.text - litBegin), fmt_segment_t::kLiteral};
+                ++r.segments;
+            }
+        };
+
+        if (f.size() > 0xffff)
+            format_string_error_too_long();
+
+        for(size_t i = 0; i < f.size(); prev = f[i++])
         {
-            if (c == '{')
+            char c = f[i];
+            if (c != '{')
             {
-                if (prev == '\\')
+                put(c);
+                continue;
+            }
+            if (prev == '\\')
+            {
+                --r.text;//drop the escaping backslash
+                put(c);
+                continue;
+            }
+
+            flush();
+            ++i;
+            size_t targ;
+            if (i < f.size() && f[i] >= '0' && f[i] <= '9')
+            {
+                targ = 0;
+                do
                 {
-                    res += pStr - pBegin - 1;
-                    dst(std::string_view(pBegin, pStr - 1));
-                    pBegin = pStr;
+                    targ = (targ * 10) + (f[i++] - '0');
                 }
-                else
-                {
-                    if constexpr (sizeof...(args) == 0)
-                        return std::unexpected{FormatError::NotEnoughFormatArguments};
-
-                    res += pStr - pBegin;
-                    dst(std::string_view(pBegin, pStr++));
-                    //parse format argument
-                    bool explicitNumber;
-                    size_t targ;
-                    if (*pStr >= '0' && *pStr <='9')
-                    {
-                        explicitNumber = true;
-                        targ = 0;
-                        do
-                        {
-                            targ = (targ * 10) + (*pStr++ - '0');
-                        }
-                        while(*pStr >= '0' && *pStr <='9');
-                    }else
-                    {
-                        targ = arg++;
-                        explicitNumber = false;
-                    }
+                while(i < f.size() && f[i] >= '0' && f[i] <= '9');
+            }else
+                targ = arg++;
 
+            if (targ >= fmt_segment_t::kLiteral)
+                format_string_error_too_many_arguments();
 
-                    if constexpr (sizeof...(args) > 0)
-                    {
-                        if (targ < sizeof...(args))
-                        {
-                            if (*pStr == ':') ++pStr;
-                            auto pFmtBegin = pStr;
-                            while(*pStr && *pStr != '}')
-                                ++pStr;
-                            if (*pStr != '}')
-                                return std::unexpected(FormatError::InvalidFormatString);
-                            std::string_view fmtStr(pFmtBegin, pStr);
-                            if (auto r = format_nth_arg<0>(targ, fmtStr, std::forward<Dest>(dst), std::forward<Args>(args)...); !r)
-                                return r;
-                            else
-                                res += *r;
-                            pBegin = pStr + 1;
-                        }
-                        else
-                            return std::unexpected{explicitNumber ? FormatError::InvalidFormatArgumentNumber : FormatError::NotEnoughFormatArguments};
-                    }
-                }
-            }
-            prev = *pStr++;
+            if (i < f.size() && f[i] == ':') ++i;
+            size_t specBegin = r.text;
+            while(i < f.size() && f[i] != '}')
+                put(f[i++]);
+            if (i == f.size())
+                format_string_error_unterminated_placeholder();
+
+            if (pSegs) pSegs[r.segments] = {uint16_t(specBegin), uint16_t(r.text - specBegin), uint8_t(targ)};
+            ++r.segments;
+            r.args = std::max(r.args, targ + 1);
+            litBegin = r.text;
         }
-        if (pBegin != pStr)
+        flush();
+        return r;
+    }
+
+    template<fmt_literal_t S>
+    struct compiled_format_t
+    {
+        static constexpr fmt_parse_sizes_t kSizes = parse_format_string(S.view(), nullptr, nullptr);
+        static constexpr size_t kArgs = kSizes.args;
+        static constexpr size_t kSegments = kSizes.segments;
+
+        struct parsed_t
+        {
+            char text[kSizes.text + 1] = {};
+            fmt_segment_t segs[kSizes.segments + 1] = {};
+        };
+
+        static constexpr parsed_t kParsed = []{
+            parsed_t p;
+            parse_format_string(S.view(), p.text, p.segs);
+            return p;
+        }();
+
+        template<size_t I, class Dest, class ArgsTuple>
+        static bool format_segment(Dest &&dst, ArgsTuple &args, std::expected<size_t, FormatError> &res)
         {
-            dst(std::string_view(pBegin, pStr));
-            res += pStr - pBegin;
+            constexpr fmt_segment_t seg = kParsed.segs[I];
+            constexpr std::string_view sv(kParsed.text + seg.offset, seg.len);
+            if constexpr (seg.arg == fmt_segment_t::kLiteral)
+            {
+                dst(sv);
+                *res += sv.size();
+                return true;
+            }else
+            {
+                using T = std::tuple_element_t<seg.arg, ArgsTuple>;
+                if constexpr (std::is_arithmetic_v<std::remove_cvref_t<T>> || std::is_enum_v<std::remove_cvref_t<T>>)
+                    static_assert(!format_spec_t::parse(sv).tooWide, "Format width exceeds format_spec_t::kMaxWidth");
+                auto r = format_arg_to(std::forward<Dest>(dst), sv, std::get<seg.arg>(args));
+                if (!r)
+                {
+                    res = r;
+                    return false;
+                }
+                *res += *r;
+                return true;
+            }
         }
-        dst();
+    };
+
+    //usage: tools::format_to(dst, tools::compiled_fmt<"v={}">, v)
+    template<fmt_literal_t S>
+    inline constexpr compiled_format_t<S> compiled_fmt{};
+
+    namespace literals
+    {
+        //usage: tools::format_to(dst, "v={}"_fmt, v)
+        template<fmt_literal_t S>
+        consteval compiled_format_t<S> operator""_fmt() { return {}; }
+    }
+
+    //format string is parsed at compile time; only the precomputed literal segments
+    //and the argument formatters are left to run
+    template<FormatDestination Dest, fmt_literal_t S, class... Args>
+    std::expected<size_t, FormatError> format_to(Dest &&dst, compiled_format_t<S>, Args &&...args)
+    {
+        using F = compiled_format_t<S>;
+        static_assert(F::kArgs <= sizeof...(Args), "Not enough format arguments or invalid format argument number");
+
+        std::expected<size_t, FormatError> res(0);
+        auto argsTuple = std::forward_as_tuple(std::forward<Args>(args)...);
+        [&]<size_t... I>(std::index_sequence<I...>){
+            (F::template format_segment<I>(std::forward<Dest>(dst), argsTuple, res) && ...);
+        }(std::make_index_sequence<F::kSegments>());
+        if (res)
+            dst();
         return res;
     }
 
+    template<FormatDestination Dest, fmt_literal_t S, class... Args>
+    size_t format_to_silent(Dest &&dst, compiled_format_t<S> f, Args &&...args)
+    {
+        if (auto r = format_to(std::forward<Dest>(dst), f, std::forward<Args>(args)...))
+                return *r;
+        return 0;
+    }
+
+    //exact amount of bytes format_to would produce, nothing is written.
+    //Integers, strings and spans are measured without being rendered
+    template<class Fmt, class... Args>
+    std::expected<size_t, FormatError> formatted_size(Fmt &&fmt, Args &&...args)
+    {
+        CountingFormatter counter;
+        if (auto r = format_to(counter, std::forward<Fmt>(fmt), std::forward<Args>(args)...); !r)
+            return r;
+        return counter.count;
+    }
+
     template<FormatDestination Dest, class... Args>
     size_t format_to_silent(Dest &&dst, const char *pStr, Args &&...args)
     {
@@ -734,6 +1245,114 @@ namespace tools
         }
     };
 
+    //FormatDestination that streams unbounded output through a small fixed window.
+    //sink(std::string_view) is called whenever the window fills, on operator()() and on destruction.
+    //With kBuffers > 1 the windows are used in turn: a chunk handed to sink stays untouched
+    //for the next kBuffers - 1 sink calls, so sink may just start a transfer (UART/DMA/socket)
+    //and return while the following chunk is being formatted.
+    //Such a sink has to provide wait(), blocking until the transfer it started last is over.
+    //It's called before every further sink call (so that at most one transfer is in flight
+    //and a window is never reused while being sent) and by the destructor, so no chunk
+    //outlives the formatter. A sink without wait() has to be done with a chunk when it returns.
+    template<size_t N, class Sink, size_t kBuffers = 1>
+    struct ChunkedFormatter
+    {
+        static_assert(N > 0 && kBuffers > 0);
+        static constexpr bool kAsyncSink = requires(std::remove_reference_t<Sink> &s) { s.wait(); };
+
+        ChunkedFormatter(Sink sink): m_Sink(std::forward<Sink>(sink)) {}
+        ChunkedFormatter(ChunkedFormatter const&) = delete;
+        ChunkedFormatter& operator=(ChunkedFormatter const&) = delete;
+        ~ChunkedFormatter()
+        {
+            flush();
+            if constexpr (kAsyncSink)
+                m_Sink.wait();
+        }
+
+        void operator()(char c)
+        {
+            if (m_Size == N)
+                flush();
+            m_Buf[m_Cur][m_Size++] = c;
+        }
+
+        void operator()(std::string_view sv)
+        {
+            if constexpr (kBuffers == 1)
+            {
+                //nothing to keep alive past the sink call: big pieces go out without a copy
+                if (sv.size() >= N)
+                {
+                    flush();
+                    send(sv);
+                    m_Total += sv.size();
+                    return;
+                }
+            }
+            while(!sv.empty())
+            {
+                if (m_Size == N)
+                    flush();
+                size_t sizeToCopy = std::min(N - m_Size, sv.size());
+                std::memcpy(m_Buf[m_Cur] + m_Size, sv.data(), sizeToCopy);
+                m_Size += sizeToCopy;
+                sv.remove_prefix(sizeToCopy);
+            }
+        }
+
+        void operator()(const char* pStr) { (*this)(std::string_view(pStr)); }
+
+        void operator()() { flush(); }
+
+        void flush()
+        {
+            if (m_Size)
+            {
+                send(std::string_view(m_Buf[m_Cur], m_Size));
+                m_Total += m_Size;
+                m_Size = 0;
+                if constexpr (kBuffers > 1)
+                    m_Cur = (m_Cur + 1) % kBuffers;
+            }
+        }
+
+        //amount of bytes passed to sink so far
+        size_t total() const { return m_Total; }
+
+    private:
+        void send(std::string_view sv)
+        {
+            if constexpr (kAsyncSink)
+            {
+                if constexpr (kBuffers == 1)
+                {
+                    //a single window (or the caller's string) is reused right away
+                    m_Sink(sv);
+                    m_Sink.wait();
+                }else
+                {
+                    m_Sink.wait();
+                    m_Sink(sv);
+                }
+            }else
+                m_Sink(sv);
+        }
+
+        Sink m_Sink;
+        size_t m_Total = 0;
+        size_t m_Size = 0;
+        size_t m_Cur = 0;
+        char m_Buf[kBuffers][N];
+    };
+
+    //the formatter only lives for the call: an async sink (see ChunkedFormatter) is waited for before returning
+    template<size_t N = 64, size_t kBuffers = 1, class Sink, class Fmt, class... T>
+    std::expected<size_t, FormatError> format_to_sink(Sink &&sink, Fmt &&fmt, T&&... args)
+    {
+        return tools::format_to(ChunkedFormatter<N, Sink, kBuffers>(std::forward<Sink>(sink)), std::forward<Fmt>(fmt), std::forward<T>(args)...);
+    }
+
     template<size_t N, class... T>
     std::span<char> format_to_span(char (&buf)[N], const char *fmt, T&&... args)
     {
@@ -751,6 +1370,24 @@ namespace tools
             return {};
         return {buf, buf + *r};
     }
+
+    template<size_t N, fmt_literal_t S, class... T>
+    std::span<char> format_to_span(char (&buf)[N], compiled_format_t<S> fmt, T&&... args)
+    {
+        auto r = tools::format_to(tools::BufferFormatter(buf), fmt, std::forward<T>(args)...);
+        if (!r)
+            return {};
+        return {buf, buf + *r};
+    }
+
+    template<size_t N, fmt_literal_t S, class... T>
+    std::string_view format_to_sv(char (&buf)[N], compiled_format_t<S> fmt, T&&... args)
+    {
+        auto r = tools::format_to(tools::BufferFormatter(buf), fmt, std::forward<T>(args)...);
+        if (!r)
+            return {};
+        return {buf, buf + *r};
+    }
 }
 
 #endif
@@ -1,7 +1,10 @@
 #ifndef LIB_GENERIC_FUNCTION_HPP_
 #define LIB_GENERIC_FUNCTION_HPP_
 
+#include <cstddef>
+#include <cstring>
 #include <memory>
+#include <new>
 #include <utility>
 
 template<class Sig>
@@ -11,19 +14,35 @@ template<class R, class... Args>
 struct VTable<R(Args...)>
 {
     using Sig = R(*)(Args...);
-    using Invoke = R(*)(Args...,void*);
+    //arguments travel by reference through the trampoline (see BindInvokeArg)
+    using Invoke = R(*)(Args&&...,void*);
 
     using Destr = void(*)(void*);
-    using Copy = void(*)(void *pDst, const void *pSrc);
+    //false: the copy couldn't be made (spill storage exhausted), pDst holds nothing
+    using Copy = bool(*)(void *pDst, const void *pSrc);
     using Move = void(*)(void *pDst, void *pSrc);
 
+    const Invoke m_Invoke;
+    //nullptr: trivially copyable target, copied/moved with memcpy, nothing to destroy
     const Destr m_Dtr;
     const Copy m_Copy;
     const Move m_Move;
 };
 
+//binds a caller's argument to the trampoline parameter P&&.
+//A by-value parameter is materialized here (one copy from an lvalue, one move-construct from a different type),
+//an rvalue of the same type and reference parameters are passed through untouched
+template<class P, class A>
+decltype(auto) BindInvokeArg(A &&a)
+{
+    if constexpr (std::is_reference_v<P> || (!std::is_lvalue_reference_v<A> && std::is_same_v<std::remove_cvref_t<A>, P>))
+        return std::forward<A>(a);
+    else
+        return P(std::forward<A>(a));
+}
+
 template<class R, class... Args>
-R InvokeFunction(Args... args, void *pF)
+R InvokeFunction(Args&&... args, void *pF)
 {
     using S = VTable<R(Args...)>::Sig;
     S *pS = (S*)pF;
@@ -31,37 +50,44 @@ R InvokeFunction(Args... args, void *pF)
 }
 
 template<class F, class R, class... Args>
-R InvokeFunctor(Args... args, void *pF)
+R InvokeFunctor(Args&&... args, void *pF)
 {
     F *pS = (F*)pF;
     return (*pS)(std::forward<Args>(args)...);
 }
 
+template<class F, class R, class... Args>
+R InvokeSpilledFunctor(Args&&... args, void *pF)
+{
+    F *pS = *(F**)pF;
+    return (*pS)(std::forward<Args>(args)...);
+}
+
 template<class R, class... Args>
 const VTable<R(Args...)> v_PlainFunc = {
-    /*dtr*/ [](void *pF){},
-    /*copy*/[](void *_pDst, const void *_pSrc){
-        using S = VTable<R(Args...)>::Sig;
-        S *pDst = (S*)_pDst;
-        const S *pSrc = (const S*)_pSrc;
-        *pDst = *pSrc;
-    },
-    /*move*/[](void *_pDst, void *_pSrc){
-        using S = VTable<R(Args...)>::Sig;
-        S *pDst = (S*)_pDst;
-        S *pSrc = (S*)_pSrc;
-        *pDst = *pSrc;
-        *pSrc = nullptr;
-    },
+    /*invoke*/&InvokeFunction<R, Args...>,
+    /*dtr*/ nullptr,
+    /*copy*/nullptr,
+    /*move*/nullptr,
+};
+
+template<class F, class R, class... Args>
+const VTable<R(Args...)> v_TrivialFunctor = {
+    /*invoke*/&InvokeFunctor<F, R, Args...>,
+    /*dtr*/ nullptr,
+    /*copy*/nullptr,
+    /*move*/nullptr,
 };
 
 template<class F, class R, class... Args>
 const VTable<R(Args...)> v_Functor = {
+    /*invoke*/&InvokeFunctor<F, R, Args...>,
     /*dtr*/ [](void *pF){ std::destroy_at((F*)pF); },
     /*copy*/[](void *_pDst, const void *_pSrc){
         F *pDst = (F*)_pDst;
         const F *pSrc = (const F*)_pSrc;
         pDst = new (pDst) F(*pSrc);
+        return true;
     },
     /*move*/[](void *_pDst, void *_pSrc){
         F *pDst = (F*)_pDst;
@@ -72,17 +98,20 @@ const VTable<R(Args...)> v_Functor = {
 
 template<class F, class R, class... Args>
 const VTable<R(Args...)> v_FunctorCopyOnly = {
+    /*invoke*/&InvokeFunctor<F, R, Args...>,
     /*dtr*/ [](void *pF){ std::destroy_at((F*)pF); },
     /*copy*/[](void *_pDst, const void *_pSrc){
         F *pDst = (F*)_pDst;
         const F *pSrc = (const F*)_pSrc;
         pDst = new (pDst) F(*pSrc);
+        return true;
     },
     /*move*/nullptr
 };
 
 template<class F, class R, class... Args>
 const VTable<R(Args...)> v_FunctorMoveOnly = {
+    /*invoke*/&InvokeFunctor<F, R, Args...>,
     /*dtr*/ [](void *pF){ std::destroy_at((F*)pF); },
     /*copy*/nullptr,
     /*move*/[](void *_pDst, void *_pSrc){
@@ -94,26 +123,107 @@ const VTable<R(Args...)> v_FunctorMoveOnly = {
 
 template<class F, class R, class... Args>
 const VTable<R(Args...)> v_FunctorImmovable = {
+    /*invoke*/&InvokeFunctor<F, R, Args...>,
     /*dtr*/ [](void *pF){ std::destroy_at((F*)pF); },
     /*copy*/nullptr,
     /*move*/nullptr
 };
 
-template<size_t Sz, class Sig>
+//spill policies: where FixedFunction puts functors that don't fit into its inline storage
+//default: they don't compile.
+//If the spill storage is exhausted, constructing or copying a FixedFunction leaves it empty (operator bool is false)
+struct FunctionNoSpill {};
+
+//small heap block per spilled functor
+struct FunctionHeapSpill
+{
+    template<class F>
+    static void* Alloc() { return ::operator new(sizeof(F), std::align_val_t(alignof(F)), std::nothrow); }
+
+    template<class F>
+    static void Free(void *p) { ::operator delete(p, std::align_val_t(alignof(F))); }
+};
+
+//storage block type for a caller provided ObjectPool used with FunctionPoolSpill:
+//  ObjectPool<FunctionSpillBlock<64>, 8> g_CallbackSpill;
+//  FixedFunction<16, void(), FunctionPoolSpill<g_CallbackSpill>> f;
+template<size_t Sz>
+struct alignas(16) FunctionSpillBlock
+{
+    std::byte m_Data[Sz];
+};
+
+template<auto &pool>
+struct FunctionPoolSpill
+{
+    template<class F>
+    static void* Alloc()
+    {
+        using Block = std::remove_pointer_t<decltype(pool.Acquire())>;
+        static_assert(sizeof(F) <= sizeof(Block) && alignof(F) <= alignof(Block), "Functor doesn't fit into a spill pool block");
+        return pool.Acquire();
+    }
+
+    template<class F>
+    static void Free(void *p) { pool.Release((std::remove_pointer_t<decltype(pool.Acquire())>*)p); }
+};
+
+//not a spill policy: selects the FixedFunction specialization for trivially copyable functors only
+struct FunctionTrivialOnly {};
+
+template<class F, class Spill, class R, class... Args>
+constexpr typename VTable<R(Args...)>::Copy SpilledFunctorCopy()
+{
+    if constexpr (std::is_copy_constructible_v<F>)
+        return [](void *_pDst, const void *_pSrc){
+            const F *pSrc = *(F* const*)_pSrc;
+            void *pMem = Spill::template Alloc<F>();
+            *(F**)_pDst = pMem ? new (pMem) F(*pSrc) : nullptr;
+            return pMem != nullptr;
+        };
+    else
+        return nullptr;
+}
+
+//the inline storage of a spilled functor only holds a pointer to it
+template<class F, class Spill, class R, class... Args>
+const VTable<R(Args...)> v_SpilledFunctor = {
+    /*invoke*/&InvokeSpilledFunctor<F, R, Args...>,
+    /*dtr*/ [](void *pF){
+        if (F *pS = *(F**)pF)
+        {
+            std::destroy_at(pS);
+            Spill::template Free<F>(pS);
+        }
+    },
+    /*copy*/SpilledFunctorCopy<F, Spill, R, Args...>(),
+    /*move*/[](void *_pDst, void *_pSrc){
+        *(F**)_pDst = *(F**)_pSrc;
+        *(F**)_pSrc = nullptr;
+    },
+};
+
+template<size_t Sz, class Sig, class Spill = FunctionNoSpill>
 class FixedFunction;
 
-template<size_t Sz, class R, class...Args>
-class FixedFunction<Sz, R(Args...)>
+template<size_t Sz, class R, class...Args, class Spill>
+class FixedFunction<Sz, R(Args...), Spill>
 {
     using VTableType = VTable<R(Args...)>;
-    using InvokeT = typename VTableType::Invoke;
+
+    template<class F>
+    static constexpr bool kFitsInline = sizeof(F) <= Sz && alignof(F) <= alignof(std::max_align_t);
 
     template<class F>
     static const VTableType* GetVTableFor()
     {
         constexpr bool copy_ok = std::is_copy_constructible_v<F>;
         constexpr bool move_ok = std::is_move_constructible_v<F>;
-        if constexpr (copy_ok && move_ok)
+        if constexpr (!kFitsInline<F>)
+            return &v_SpilledFunctor<F, Spill, R, Args...>;
+        else if constexpr (std::is_trivially_copyable_v<F>)
+            return &v_TrivialFunctor<F, R, Args...>;
+        else if constexpr (copy_ok && move_ok)
             return &v_Functor<F, R, Args...>;
         else if constexpr (copy_ok)
             return &v_FunctorCopyOnly<F, R, Args...>;
@@ -128,53 +238,149 @@ public:
 
     FixedFunction(R(*pF)(Args...)):
         m_pTable(&v_PlainFunc<R,Args...>)
-        ,m_pInvoker(&InvokeFunction<R, Args...>)
     {
         static_assert(sizeof(pF) <= Sz);
         *((typename VTableType::Sig*)m_Storage) = pF;
     }
 
-    template<class F>
-    FixedFunction(F &&f):
-        m_pTable(GetVTableFor<F>())
-        ,m_pInvoker(&InvokeFunctor<F, R, Args...>)
+    template<class F> requires (!std::is_same_v<std::remove_cvref_t<F>, FixedFunction>)
+    FixedFunction(F &&f)
+    {
+        using Fn = std::remove_cvref_t<F>;
+        if constexpr (kFitsInline<Fn>)
+            new (m_Storage) Fn(std::forward<F>(f));
+        else
+        {
+            static_assert(!std::is_same_v<Spill, FunctionNoSpill>, "Functor doesn't fit: increase Sz or use a spill policy");
+            void *pMem = Spill::template Alloc<Fn>();
+            if (!pMem)
+                return;//spill storage exhausted: stays empty
+            *(Fn**)m_Storage = new (pMem) Fn(std::forward<F>(f));
+        }
+        m_pTable = GetVTableFor<Fn>();
+    }
+
+    FixedFunction(const FixedFunction &src):
+        m_pTable(src.m_pTable)
     {
-        static_assert(sizeof(F) <= Sz);
-        static_assert(std::is_move_constructible_v<F>);
-        m_pTable->m_Move(m_Storage, &f);
+        CopyFrom(src);
     }
 
+    FixedFunction(FixedFunction &&src):
+        m_pTable(src.m_pTable)
+    {
+        MoveFrom(src);
+    }
+
+    ~FixedFunction() { reset(); }
+
     FixedFunction& operator=(const FixedFunction &src)
     {
-        m_pTable = src.m_pTable;
-        m_pInvoker = src.m_pInvoker;
-        m_pTable->m_Copy(m_Storage, src.m_Storage);
+        if (this != &src)
+        {
+            reset();
+            m_pTable = src.m_pTable;
+            CopyFrom(src);
+        }
         return *this;
     }
 
     FixedFunction& operator=(FixedFunction &&src)
     {
-        m_pTable = src.m_pTable;
-        m_pInvoker = src.m_pInvoker;
-        m_pTable->m_Move(m_Storage, src.m_Storage);
+        if (this != &src)
+        {
+            reset();
+            m_pTable = src.m_pTable;
+            MoveFrom(src);
+        }
         return *this;
     }
 
+    void reset()
+    {
+        if (m_pTable && m_pTable->m_Dtr)
+            m_pTable->m_Dtr(m_Storage);
+        m_pTable = nullptr;
+    }
+
     operator bool() const { return m_pTable != nullptr; }
 
     template<class...A>
     R operator()(A&&... args)
     {
-        return m_pInvoker(std::forward<Args>(args)..., m_Storage);
+        return m_pTable->m_Invoke(BindInvokeArg<Args>(std::forward<A>(args))..., m_Storage);
     }
 
 private:
-    alignas(16) std::byte m_Storage[Sz];
+    void CopyFrom(const FixedFunction &src)
+    {
+        if (!m_pTable) return;
+        if (!m_pTable->m_Dtr)
+            std::memcpy(m_Storage, src.m_Storage, Sz);
+        else if (!m_pTable->m_Copy(m_Storage, src.m_Storage))
+            m_pTable = nullptr;//spill storage exhausted: the copy stays empty
+    }
+
+    void MoveFrom(FixedFunction &src)
+    {
+        if (!m_pTable) return;
+        if (!m_pTable->m_Dtr)
+            std::memcpy(m_Storage, src.m_Storage, Sz);
+        else
+            m_pTable->m_Move(m_Storage, src.m_Storage);
+        //moved-from is empty (a spilled source doesn't own its functor anymore)
+        src.reset();
+    }
+
+    alignas(std::max_align_t) std::byte m_Storage[Sz];
     const VTableType *m_pTable = nullptr;
+};
+
+//trivially copyable functors only: no vtable, the object itself is trivially copyable
+//(copied/moved with memcpy, nothing to destroy) and stores just the invoker
+template<size_t Sz, class R, class...Args>
+class FixedFunction<Sz, R(Args...), FunctionTrivialOnly>
+{
+    using InvokeT = typename VTable<R(Args...)>::Invoke;
+public:
+    FixedFunction() = default;
+
+    FixedFunction(R(*pF)(Args...)):
+        m_pInvoker(&InvokeFunction<R, Args...>)
+    {
+        static_assert(sizeof(pF) <= Sz);
+        *((typename VTable<R(Args...)>::Sig*)m_Storage) = pF;
+    }
+
+    template<class F> requires (!std::is_same_v<std::remove_cvref_t<F>, FixedFunction>)
+    FixedFunction(F &&f):
+        m_pInvoker(&InvokeFunctor<std::remove_cvref_t<F>, R, Args...>)
+    {
+        using Fn = std::remove_cvref_t<F>;
+        static_assert(std::is_trivially_copyable_v<Fn>, "Functor must be trivially copyable");
+        static_assert(sizeof(Fn) <= Sz && alignof(Fn) <= alignof(std::max_align_t));
+        new (m_Storage) Fn(std::forward<F>(f));
+    }
+
+    void reset() { m_pInvoker = nullptr; }
+
+    operator bool() const { return m_pInvoker != nullptr; }
+
+    template<class...A>
+    R operator()(A&&... args)
+    {
+        return m_pInvoker(BindInvokeArg<Args>(std::forward<A>(args))..., m_Storage);
+    }
+
+private:
+    alignas(std::max_align_t) std::byte m_Storage[Sz];
     InvokeT m_pInvoker = nullptr;
 };
 
 template<class Sig>
 using GenericCallback = FixedFunction<48, Sig>;
 
+template<class Sig>
+using TrivialCallback = FixedFunction<48, Sig, FunctionTrivialOnly>;
+
 #endif
@@ -0,0 +1,51 @@
+#ifndef LIB_FUNCTION_REF_HPP_
+#define LIB_FUNCTION_REF_HPP_
+
+#include <type_traits>
+#include <utility>
+#include <memory>
+#include "lib_function.hpp"
+
+template<class Sig>
+class FunctionRef;
+
+//non-owning view of a callable: an object pointer and a trampoline, nothing else.
+//For callbacks that are only invoked during the call they're passed to (visitors, predicates):
+//  void ForEach(FunctionRef<void(Item&)> visit);
+//The referenced callable must outlive the FunctionRef (temporaries live until the end of the full expression)
+template<class R, class... Args>
+class FunctionRef<R(Args...)>
+{
+    union Target
+    {
+        void *pObj;
+        R(*pFunc)(Args...);
+    };
+    using InvokeT = R(*)(Target, Args&&...);
+
+public:
+    FunctionRef(R(*pF)(Args...)):
+        m_pInvoker([](Target t, Args&&... args)->R{ return t.pFunc(std::forward<Args>(args)...); })
+    {
+        m_Target.pFunc = pF;
+    }
+
+    template<class F> requires (!std::is_same_v<std::remove_cvref_t<F>, FunctionRef> && std::is_invocable_r_v<R, F&, Args...>)
+    FunctionRef(F &&f):
+        m_pInvoker([](Target t, Args&&... args)->R{ return (*(std::remove_reference_t<F>*)t.pObj)(std::forward<Args>(args)...); })
+    {
+        m_Target.pObj = (void*)std::addressof(f);
+    }
+
+    template<class...A>
+    R operator()(A&&... args) const
+    {
+        return m_pInvoker(m_Target, BindInvokeArg<Args>(std::forward<A>(args))...);
+    }
+
+private:
+    Target m_Target;
+    InvokeT m_pInvoker;
+};
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef LIB_MAGAZINE_POOL_HPP_
+#define LIB_MAGAZINE_POOL_HPP_
+
+#include <new>
+#include <span>
+#include <utility>
+#include "lib_object_pool.hpp"
+#include "freertos/FreeRTOS.h"
+
+//current core's magazine: interrupts are masked on this core only, so neither
+//a task switch (and migration) nor an ISR can interleave. No shared state is touched.
+struct CoreLocalSection
+{
+    static constexpr size_t kCount = portNUM_PROCESSORS;
+
+    CoreLocalSection(): m_State(portSET_INTERRUPT_MASK_FROM_ISR()) {}
+    ~CoreLocalSection() { portCLEAR_INTERRUPT_MASK_FROM_ISR(m_State); }
+
+    size_t index() const { return xPortGetCoreID(); }
+private:
+    UBaseType_t m_State;
+};
+
+//per-core caches of free slots (magazines) in front of a shared pool.
+//Acquire/Release work on the current core's magazine; only when it runs empty or full
+//kMagazine/2 slots are moved from/to the shared pool in one batch (AcquireSlotN/ReleaseSlotN).
+//The shared pool must be safe to use from all cores (e.g. LockFreeObjectPool).
+//Slots sitting in a magazine count as allocated for the shared pool.
+//  LockFreeObjectPool<Msg, 64> g_MsgPool;
+//  MagazinePool g_Msgs(g_MsgPool);
+template<class Pool, size_t kMagazine = 8, class Local = CoreLocalSection>
+class MagazinePool
+{
+    static_assert(kMagazine >= 2 && kMagazine <= 255);
+public:
+    using value_type = typename Pool::value_type;
+    using T = value_type;
+
+    template<MagazinePool &staticPool>
+    using Ptr = PoolPtr<staticPool>;
+
+    constexpr MagazinePool(Pool &pool): m_Pool(pool) {}
+    MagazinePool(const MagazinePool&) = delete;
+    MagazinePool& operator=(const MagazinePool&) = delete;
+
+    template<class... Args>
+    T* Acquire(Args&&... args)
+    {
+        T *pSlot = AcquireSlot();
+        if (!pSlot) return nullptr;
+        return new (pSlot) T{std::forward<Args>(args)...};
+    }
+
+    void Release(T* pPtr)
+    {
+        if (pPtr)
+        {
+            if constexpr (!simple_destructible_t<T>)
+                pPtr->~T();
+            ReleaseSlot(pPtr);
+        }
+    }
+
+    T* AcquireSlot()
+    {
+        Local l;
+        Magazine &m = m_Magazines[l.index()];
+        if (!m.m_Count)
+        {
+            m.m_Count = m_Pool.AcquireSlotN(std::span<T*>(m.m_Slots, kMagazine / 2));
+            if (!m.m_Count)
+                return nullptr;
+        }
+        return m.m_Slots[--m.m_Count];
+    }
+
+    void ReleaseSlot(T* pPtr)
+    {
+        Local l;
+        Magazine &m = m_Magazines[l.index()];
+        if (m.m_Count == kMagazine)
+        {
+            m_Pool.ReleaseSlotN(std::span<T* const>(m.m_Slots + kMagazine / 2, kMagazine - kMagazine / 2));
+            m.m_Count = kMagazine / 2;
+        }
+        m.m_Slots[m.m_Count++] = pPtr;
+    }
+
+    //returns the current core's cached slots to the shared pool
+    void FlushLocal()
+    {
+        Local l;
+        Magazine &m = m_Magazines[l.index()];
+        m_Pool.ReleaseSlotN(std::span<T* const>(m.m_Slots, m.m_Count));
+        m.m_Count = 0;
+    }
+
+    bool IsValid(T *pPtr) const { return m_Pool.IsValid(pPtr); }
+
+    Pool& SharedPool() { return m_Pool; }
+
+private:
+    struct Magazine
+    {
+        T *m_Slots[kMagazine];
+        uint8_t m_Count = 0;
+    };
+
+    Pool &m_Pool;
+    //each on its own cache line: the cores don't share anything on the fast path
+    struct alignas(kCacheLineSize) PaddedMagazine: Magazine {};
+    PaddedMagazine m_Magazines[Local::kCount];
+};
+
+#endif
@@ -54,12 +54,18 @@ struct WithInvalidState
 #if defined(NDEBUG) && !defined(FORCE_FMT)
 #define FMT_PRINT(fmt,...) {}
 #define FMT_PRINTLN(fmt,...) {}
+#elif defined(FMT_DEFERRED)
+//only the arguments are captured on the calling task; tools::g_DeferredLog.drain() does the formatting
+#include "lib_deferred_log.hpp"
+#define FMT_PRINT(fmt,...) { tools::g_DeferredLog.write(tools::compiled_fmt<fmt> __VA_OPT__(,) __VA_ARGS__); }
+#define FMT_PRINTLN(fmt,...) { tools::g_DeferredLog.write(tools::compiled_fmt<fmt "\n"> __VA_OPT__(,) __VA_ARGS__); }
 #else
 #ifndef PRINTF_FUNC
 #define PRINTF_FUNC(...) printf(__VA_ARGS__)
 #endif
-#define FMT_PRINT(fmt,...) { char buf[256]; tools::format_to_silent(tools::BufferFormatter(buf), fmt __VA_OPT__(,) __VA_ARGS__); PRINTF_FUNC("%s", buf); }
-#define FMT_PRINTLN(fmt,...) { char buf[256]; tools::format_to_silent(tools::BufferFormatter(buf), fmt "\n" __VA_OPT__(,) __VA_ARGS__); PRINTF_FUNC("%s", buf); }
+//fmt must be a string literal: it's parsed and checked against the arguments at compile time
+#define FMT_PRINT(fmt,...) { char buf[256]; tools::format_to_silent(tools::BufferFormatter(buf), tools::compiled_fmt<fmt> __VA_OPT__(,) __VA_ARGS__); PRINTF_FUNC("%s", buf); }
+#define FMT_PRINTLN(fmt,...) { char buf[256]; tools::format_to_silent(tools::BufferFormatter(buf), tools::compiled_fmt<fmt "\n"> __VA_OPT__(,) __VA_ARGS__); PRINTF_FUNC("%s", buf); }
 #endif
 
 #endif
@@ -2,6 +2,10 @@
 #define LIB_OBJECT_POOL_HPP_
 
 #include <assert.h>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <span>
 #include "lib_type_traits.hpp"
 
 
@@ -14,67 +18,176 @@ public:
     static constexpr size_t data_count = (N + bits_per_element - 1) / bits_per_element;
     static constexpr size_t BitCount = N;
 
+    //iterates over the indices of the set bits
+    class iterator
+    {
+    public:
+        using value_type = size_t;
+        using difference_type = ptrdiff_t;
+
+        iterator() = default;
+        iterator(const MinBitSet *pSet, size_t bit): m_pSet(pSet), m_Bit(bit) {}
+
+        size_t operator*() const { return m_Bit; }
+        iterator& operator++() { m_Bit = m_pSet->find_first_set(m_Bit + 1); return *this; }
+        iterator operator++(int) { iterator r = *this; ++*this; return r; }
+        bool operator==(iterator const& rhs) const { return m_Bit == rhs.m_Bit; }
+    private:
+        const MinBitSet *m_pSet = nullptr;
+        size_t m_Bit = N;
+    };
+
     constexpr MinBitSet() = default;
 
     bool test(size_t bit) const
     {
-        return (m_Data[bit / bits_per_element] & (1 << (bit % bits_per_element))) != 0;
+        return (m_Data[bit / bits_per_element] & mask(bit)) != 0;
     }
 
     void set(size_t bit)
     {
-        m_Data[bit / bits_per_element] |= 1 << (bit % bits_per_element);
+        m_Data[bit / bits_per_element] |= mask(bit);
     }
 
     void reset(size_t bit)
     {
-        m_Data[bit / bits_per_element] &= ~(1 << (bit % bits_per_element));
+        m_Data[bit / bits_per_element] &= ~mask(bit);
+    }
+
+    //index of the first set bit >= from or BitCount
+    size_t find_first_set(size_t from = 0) const
+    {
+        if (from >= N) return N;
+        size_t w = from / bits_per_element;
+        size_type v = m_Data[w] & (size_type(~size_type(0)) << (from % bits_per_element));
+        while(!v)
+        {
+            if (++w >= data_count) return N;
+            v = m_Data[w];
+        }
+        return std::min<size_t>(w * bits_per_element + std::countr_zero(v), N);
+    }
+
+    //index of the first clear bit >= from or BitCount
+    size_t find_first_clear(size_t from = 0) const
+    {
+        if (from >= N) return N;
+        size_t w = from / bits_per_element;
+        size_type v = size_type(~m_Data[w]) & (size_type(~size_type(0)) << (from % bits_per_element));
+        while(!v)
+        {
+            if (++w >= data_count) return N;
+            v = size_type(~m_Data[w]);
+        }
+        return std::min<size_t>(w * bits_per_element + std::countr_zero(v), N);
+    }
+
+    size_t count() const
+    {
+        size_t res = 0;
+        for(size_type v : m_Data)
+            res += std::popcount(v);
+        return res;
+    }
+
+    bool any() const
+    {
+        for(size_type v : m_Data)
+            if (v) return true;
+        return false;
     }
 
+    //word-level updates, mask is in bit positions of word w
+    void set_bits(size_t w, size_type m) { m_Data[w] |= m; }
+    void reset_bits(size_t w, size_type m) { m_Data[w] &= ~m; }
+
+    iterator begin() const { return iterator(this, find_first_set()); }
+    iterator end() const { return iterator(this, N); }
+
+    static constexpr size_type mask(size_t bit) { return size_type(1) << (bit % bits_per_element); }
+
 private:
     size_type m_Data[data_count] = {};
 };
 
-template<class T, size_t N>
+//batches of bit updates: calls apply(word, mask) once per run of indices that fall into the same word
+template<class Word, class IdxAt, class Apply>
+void ForEachWordMask(size_t n, IdxAt &&idxAt, Apply &&apply)
+{
+    constexpr size_t kBits = sizeof(Word) * 8;
+    size_t w = 0;
+    Word m = 0;
+    for(size_t k = 0; k < n; ++k)
+    {
+        const size_t i = idxAt(k);
+        if (i / kBits != w)
+        {
+            if (m) apply(w, m);
+            w = i / kBits;
+            m = 0;
+        }
+        m |= Word(1) << (i % kBits);
+    }
+    if (m) apply(w, m);
+}
+
+//owning pointer to an object of a statically allocated pool, released on destruction
+template<auto &staticPool>
+class PoolPtr
+{
+public:
+    using T = typename std::remove_reference_t<decltype(staticPool)>::value_type;
+    using can_relocate = void;
+
+    PoolPtr() = default;
+    PoolPtr(T *pPtr): m_pPtr(pPtr) {}
+    template<class... Args>// requires (!(std::is_same_v<std::remove_cvref_t<Args>, T*>||...))
+    PoolPtr(Args&&... args):m_pPtr(staticPool.Acquire(std::forward<Args>(args)...)) { }
+    ~PoolPtr() { staticPool.Release(m_pPtr); }
+
+    PoolPtr(const PoolPtr&) = delete;//no copy
+    PoolPtr& operator=(const PoolPtr &rhs) = delete;
+
+    //move ok
+    PoolPtr(PoolPtr &&rhs): m_pPtr(rhs.m_pPtr) { rhs.m_pPtr = nullptr; }
+    PoolPtr& operator=(PoolPtr &&rhs)
+    { 
+        m_pPtr = rhs.m_pPtr;
+        rhs.m_pPtr = nullptr; 
+        return *this;
+    }
+
+    void reset(T *pNew = nullptr) { staticPool.Release(m_pPtr); m_pPtr = pNew; }
+    T* release() { auto *pRes = m_pPtr; m_pPtr = nullptr; return pRes; }
+
+    auto operator->() const { return m_pPtr; }
+    operator T*() const { return m_pPtr; }
+    T& operator *() const { return *m_pPtr; }
+private:
+    T *m_pPtr = nullptr;
+};
+
+//default ObjectPool statistics: none, every hook compiles away (see PoolStats in lib_pool_stats.hpp)
+template<size_t N>
+struct NoPoolStats
+{
+    void OnAcquire(size_t idx) {}
+    void OnAcquireFailed() {}
+    void OnRelease(size_t idx) {}
+};
+
+template<class T, size_t N, template<size_t> class StatsT = NoPoolStats>
 class ObjectPool
 {
 public:
     using size_type = MinSizeType<N>::type;
     static constexpr size_type kInvalid = N;
 
-    template<ObjectPool<T,N> &staticPool>
-    class Ptr
-    {
-    public:
-        using can_relocate = void;
-
-        Ptr() = default;
-        Ptr(T *pPtr): m_pPtr(pPtr) {}
-        template<class... Args>// requires (!(std::is_same_v<std::remove_cvref_t<Args>, T*>||...))
-        Ptr(Args&&... args):m_pPtr(staticPool.Acquire(std::forward<Args>(args)...)) { }
-        ~Ptr() { staticPool.Release(m_pPtr); }
-
-        Ptr(const Ptr&) = delete;//no copy
-        Ptr& operator=(const Ptr &rhs) = delete;
-
-        //move ok
-        Ptr(Ptr &&rhs): m_pPtr(rhs.m_pPtr) { rhs.m_pPtr = nullptr; }
-        Ptr& operator=(Ptr &&rhs)
-        { 
-            m_pPtr = rhs.m_pPtr;
-            rhs.m_pPtr = nullptr; 
-            return *this;
-        }
+    using value_type = T;
+    using stats_type = StatsT<N>;
 
-        void reset(T *pNew = nullptr) { staticPool.Release(m_pPtr); m_pPtr = pNew; }
-        T* release() { auto *pRes = m_pPtr; m_pPtr = nullptr; return pRes; }
-
-        auto operator->() const { return m_pPtr; }
-        operator T*() const { return m_pPtr; }
-        T& operator *() const { return *m_pPtr; }
-    private:
-        T *m_pPtr = nullptr;
-    };
+    template<ObjectPool &staticPool>
+    using Ptr = PoolPtr<staticPool>;
 
     constexpr ObjectPool()
     {
@@ -107,32 +220,126 @@ public:
         return false;
     }
 
+    //whether p points into this pool's storage
+    bool Owns(const void *p) const
+    {
+        return (p >= (const void*)m_Data) && (p < (const void*)(m_Data + N));
+    }
+
     template<class... Args>
     T* Acquire(Args&&... args)
     {
-        if (m_FirstFree >= N) return nullptr;
-        auto i = m_FirstFree;
-        m_FirstFree = m_Data[m_FirstFree].m_NextFree;
-        m_Allocated.set(i);
-        return new (&m_Data[i].m_Object) T{std::forward<Args>(args)...};
+        T *pSlot = AcquireSlot();
+        if (!pSlot) return nullptr;
+        return new (pSlot) T{std::forward<Args>(args)...};
     }
 
     void Release(T* pPtr)
     {
         if (pPtr)
         {
-            assert(((Elem*)pPtr >= m_Data) && ((Elem*)pPtr < (m_Data + N)));
             if constexpr (!simple_destructible_t<T>)
                 pPtr->~T();
-            size_t i = (Elem*)pPtr - m_Data;
-            m_Data[i].m_NextFree = m_FirstFree;
-            m_FirstFree = i;
-            m_Allocated.reset(m_FirstFree);
+            ReleaseSlot(pPtr);
         }
     }
 
+    //raw slots: no construction/destruction, for layers on top of the pool
+    T* AcquireSlot()
+    {
+        if (m_FirstFree >= N)
+        {
+            m_Stats.OnAcquireFailed();
+            return nullptr;
+        }
+        auto i = m_FirstFree;
+        m_FirstFree = m_Data[m_FirstFree].m_NextFree;
+        m_Allocated.set(i);
+        m_Stats.OnAcquire(i);
+        return &m_Data[i].m_Object;
+    }
+
+    void ReleaseSlot(T* pPtr)
+    {
+        assert(((Elem*)pPtr >= m_Data) && ((Elem*)pPtr < (m_Data + N)));
+        size_t i = (Elem*)pPtr - m_Data;
+        m_Stats.OnRelease(i);
+        m_Data[i].m_NextFree = m_FirstFree;
+        m_FirstFree = i;
+        m_Allocated.reset(i);
+    }
+
+    //acquires up to out.size() objects, each constructed from args (copied), returns how many
+    template<class... Args>
+    size_t AcquireN(std::span<T*> out, Args const&... args)
+    {
+        const size_t n = AcquireSlotN(out);
+        for(size_t k = 0; k < n; ++k)
+            new (out[k]) T{args...};
+        return n;
+    }
+
+    void ReleaseN(std::span<T* const> objs)
+    {
+        if constexpr (!simple_destructible_t<T>)
+        {
+            for(T *pPtr : objs)
+                pPtr->~T();
+        }
+        ReleaseSlotN(objs);
+    }
+
+    //pops a chain of up to out.size() raw slots off the free list, returns how many
+    size_t AcquireSlotN(std::span<T*> out)
+    {
+        size_t n = 0;
+        size_t i = m_FirstFree;
+        for(; n < out.size() && i < N; ++n, i = m_Data[i].m_NextFree)
+        {
+            out[n] = &m_Data[i].m_Object;
+            m_Stats.OnAcquire(i);
+        }
+        if (n < out.size())
+            m_Stats.OnAcquireFailed();
+        m_FirstFree = i;
+        ForEachWordMask<typename MinBitSet<N>::size_type>(n, [&](size_t k){ return (Elem*)out[k] - m_Data; }, [&](size_t w, auto m){ m_Allocated.set_bits(w, m); });
+        return n;
+    }
+
+    //links the slots into a chain and pushes it onto the free list
+    void ReleaseSlotN(std::span<T* const> slots)
+    {
+        if (slots.empty()) return;
+        size_t next = m_FirstFree;
+        for(size_t k = slots.size(); k-- > 0;)
+        {
+            assert(((Elem*)slots[k] >= m_Data) && ((Elem*)slots[k] < (m_Data + N)));
+            const size_t i = (Elem*)slots[k] - m_Data;
+            m_Stats.OnRelease(i);
+            m_Data[i].m_NextFree = next;
+            next = i;
+        }
+        m_FirstFree = next;
+        ForEachWordMask<typename MinBitSet<N>::size_type>(slots.size(), [&](size_t k){ return (Elem*)slots[k] - m_Data; }, [&](size_t w, auto m){ m_Allocated.reset_bits(w, m); });
+    }
+
     auto const& AllocatedBitSet() const { return m_Allocated; }
+
+    //number of allocated objects
+    size_t Size() const { return m_Allocated.count(); }
+
+    //calls f(T&) for every allocated object, in index order
+    template<class F>
+    void ForEachAllocated(F &&f)
+    {
+        for(size_t i : m_Allocated)
+            f(m_Data[i].m_Object);
+    }
+
+    stats_type const& GetStats() const { return m_Stats; }
+    stats_type& GetStats() { return m_Stats; }
 private:
+    [[no_unique_address]] stats_type m_Stats;
     MinBitSet<N> m_Allocated;
     size_type m_FirstFree = 0;
     union Elem
@@ -145,4 +352,249 @@ private:
     Elem m_Data[N];
 };
 
+//ObjectPool handing out compact index+generation handles instead of pointers.
+//A handle is sizeof(size_type) + sizeof(Gen) bytes (2 for N <= 255 with the default 8-bit generation),
+//isn't tied to a pool instance and resolves in O(1). Releasing a slot bumps its generation,
+//so stale handles resolve to nullptr (until the generation wraps around after 2^bits reuses of that slot).
+template<class T, size_t N, class Gen = uint8_t, template<size_t> class StatsT = NoPoolStats>
+class HandlePool
+{
+public:
+    using pool_type = ObjectPool<T, N, StatsT>;
+    using size_type = pool_type::size_type;
+    using value_type = T;
+    static constexpr size_type kInvalid = pool_type::kInvalid;
+
+    struct Handle
+    {
+        size_type idx = kInvalid;
+        Gen gen = 0;
+
+        explicit operator bool() const { return idx != kInvalid; }
+        bool operator==(Handle const&) const = default;
+    };
+
+    template<class... Args>
+    Handle Acquire(Args&&... args)
+    {
+        T *pPtr = m_Pool.Acquire(std::forward<Args>(args)...);
+        if (!pPtr) return {};
+        const size_type i = m_Pool.PtrToIdx(pPtr);
+        return {i, m_Gen[i]};
+    }
+
+    //false for a stale or empty handle
+    bool Release(Handle h)
+    {
+        T *pPtr = Get(h);
+        if (!pPtr) return false;
+        ++m_Gen[h.idx];
+        m_Pool.Release(pPtr);
+        return true;
+    }
+
+    //nullptr for a stale or empty handle
+    T* Get(Handle h)
+    {
+        return IsValid(h) ? m_Pool.IdxToPtr(h.idx) : nullptr;
+    }
+
+    bool IsValid(Handle h) const { return h.idx < N && m_Gen[h.idx] == h.gen && m_Pool.AllocatedBitSet().test(h.idx); }
+
+    //handle of an object of this pool
+    Handle ToHandle(T *pPtr) const
+    {
+        const size_type i = m_Pool.PtrToIdx(pPtr);
+        return i < N ? Handle{i, m_Gen[i]} : Handle{};
+    }
+
+    pool_type& Pool() { return m_Pool; }
+    pool_type const& Pool() const { return m_Pool; }
+
+private:
+    pool_type m_Pool;
+    Gen m_Gen[N] = {};
+};
+
+//ObjectPool that can be shared between tasks on both cores and ISRs without a lock.
+//The free list is a Treiber stack: its head is a single 32-bit atomic word with the
+//size_type index in the low bits and an ABA tag, bumped on every change, in the remaining ones.
+//The allocation bitmap is a set of atomic words.
+template<class T, size_t N>
+class LockFreeObjectPool
+{
+    static_assert(N < 0xffff, "The free list head must fit a 32-bit atomic together with its tag");
+public:
+    using size_type = MinSizeType<N>::type;
+    static constexpr size_type kInvalid = N;
+
+    using value_type = T;
+
+    template<LockFreeObjectPool<T,N> &staticPool>
+    using Ptr = PoolPtr<staticPool>;
+
+    constexpr LockFreeObjectPool()
+    {
+        for(size_t i = 0; i < N; ++i) m_NextFree[i] = i + 1;
+    }
+
+    size_type PtrToIdx(T *pPtr) const
+    {
+        if (!pPtr) return kInvalid;
+        assert(((Elem*)pPtr >= m_Data) && ((Elem*)pPtr < (m_Data + N)));
+        size_t res = (Elem*)pPtr - m_Data;
+        assert(test(res));
+        return (size_type)res;
+    }
+
+    T *IdxToPtr(size_t idx)
+    {
+        assert((idx < N) && test(idx));
+        return &m_Data[idx].m_Object;
+    }
+
+    bool IsValid(T *pPtr) const
+    {
+        if (pPtr)
+        {
+            assert(((Elem*)pPtr >= m_Data) && ((Elem*)pPtr < (m_Data + N)));
+            return test((Elem*)pPtr - m_Data);
+        }
+        return false;
+    }
+
+    template<class... Args>
+    T* Acquire(Args&&... args)
+    {
+        T *pSlot = AcquireSlot();
+        if (!pSlot) return nullptr;
+        return new (pSlot) T{std::forward<Args>(args)...};
+    }
+
+    void Release(T* pPtr)
+    {
+        if (pPtr)
+        {
+            if constexpr (!simple_destructible_t<T>)
+                pPtr->~T();
+            ReleaseSlot(pPtr);
+        }
+    }
+
+    //raw slots: no construction/destruction, for layers on top of the pool
+    T* AcquireSlot()
+    {
+        uint32_t head = m_Head.load(std::memory_order_acquire);
+        uint32_t i;
+        do
+        {
+            i = head & kIdxMask;
+            if (i >= N) return nullptr;
+            //may read a stale value if i got popped meanwhile: the tag makes the CAS fail then
+            const uint32_t next = next_free(i).load(std::memory_order_relaxed);
+            if (m_Head.compare_exchange_weak(head, next | next_tag(head), std::memory_order_acquire, std::memory_order_acquire))
+                break;
+        }while(true);
+
+        m_Allocated[i / kBitsPerWord].fetch_or(1u << (i % kBitsPerWord), std::memory_order_relaxed);
+        return &m_Data[i].m_Object;
+    }
+
+    void ReleaseSlot(T* pPtr)
+    {
+        assert(((Elem*)pPtr >= m_Data) && ((Elem*)pPtr < (m_Data + N)));
+        const uint32_t i = (Elem*)pPtr - m_Data;
+        m_Allocated[i / kBitsPerWord].fetch_and(~(1u << (i % kBitsPerWord)), std::memory_order_relaxed);
+
+        uint32_t head = m_Head.load(std::memory_order_relaxed);
+        do
+        {
+            next_free(i).store(head & kIdxMask, std::memory_order_relaxed);
+        }while(!m_Head.compare_exchange_weak(head, i | next_tag(head), std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    template<class... Args>
+    size_t AcquireN(std::span<T*> out, Args const&... args)
+    {
+        const size_t n = AcquireSlotN(out);
+        for(size_t k = 0; k < n; ++k)
+            new (out[k]) T{args...};
+        return n;
+    }
+
+    void ReleaseN(std::span<T* const> objs)
+    {
+        if constexpr (!simple_destructible_t<T>)
+        {
+            for(T *pPtr : objs)
+                pPtr->~T();
+        }
+        ReleaseSlotN(objs);
+    }
+
+    //pops a chain of up to out.size() raw slots with a single CAS, returns how many
+    size_t AcquireSlotN(std::span<T*> out)
+    {
+        if (out.empty()) return 0;
+        uint32_t head = m_Head.load(std::memory_order_acquire);
+        size_t n;
+        uint32_t i;
+        do
+        {
+            //an unchanged tag at the CAS means nobody touched the list while the chain was read
+            n = 0;
+            i = head & kIdxMask;
+            for(; n < out.size() && i < N; ++n, i = next_free(i).load(std::memory_order_relaxed))
+                out[n] = &m_Data[i].m_Object;
+            if (!n) return 0;
+        }while(!m_Head.compare_exchange_weak(head, i | next_tag(head), std::memory_order_acquire, std::memory_order_acquire));
+
+        ForEachWordMask<uint32_t>(n, [&](size_t k){ return (Elem*)out[k] - m_Data; }, [&](size_t w, uint32_t m){ m_Allocated[w].fetch_or(m, std::memory_order_relaxed); });
+        return n;
+    }
+
+    //links the slots into a chain and pushes it with a single CAS
+    void ReleaseSlotN(std::span<T* const> slots)
+    {
+        if (slots.empty()) return;
+        ForEachWordMask<uint32_t>(slots.size(), [&](size_t k){ return (Elem*)slots[k] - m_Data; }, [&](size_t w, uint32_t m){ m_Allocated[w].fetch_and(~m, std::memory_order_relaxed); });
+
+        for(size_t k = 0; k + 1 < slots.size(); ++k)
+            next_free((Elem*)slots[k] - m_Data).store((Elem*)slots[k + 1] - m_Data, std::memory_order_relaxed);
+        const uint32_t first = (Elem*)slots.front() - m_Data;
+        const size_t last = (Elem*)slots.back() - m_Data;
+        uint32_t head = m_Head.load(std::memory_order_relaxed);
+        do
+        {
+            next_free(last).store(head & kIdxMask, std::memory_order_relaxed);
+        }while(!m_Head.compare_exchange_weak(head, first | next_tag(head), std::memory_order_release, std::memory_order_relaxed));
+    }
+
+private:
+    static constexpr uint32_t kIdxBits = sizeof(size_type) * 8;
+    static constexpr uint32_t kIdxMask = (uint32_t(1) << kIdxBits) - 1;
+    static constexpr size_t kBitsPerWord = 32;
+
+    static uint32_t next_tag(uint32_t head) { return (head & ~kIdxMask) + (kIdxMask + 1); }
+
+    std::atomic_ref<size_type> next_free(size_t i) { return std::atomic_ref<size_type>(m_NextFree[i]); }
+
+    bool test(size_t i) const
+    {
+        return (m_Allocated[i / kBitsPerWord].load(std::memory_order_relaxed) & (1u << (i % kBitsPerWord))) != 0;
+    }
+
+    union Elem
+    {
+        constexpr Elem(){}
+        ~Elem(){}
+        T m_Object;
+    };
+
+    std::atomic<uint32_t> m_Head{0};
+    std::atomic<uint32_t> m_Allocated[(N + kBitsPerWord - 1) / kBitsPerWord] = {};
+    alignas(std::atomic_ref<size_type>::required_alignment) size_type m_NextFree[N];
+    Elem m_Data[N];
+};
+
 #endif
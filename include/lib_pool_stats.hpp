@@ -0,0 +1,121 @@
+#ifndef LIB_POOL_STATS_HPP_
+#define LIB_POOL_STATS_HPP_
+
+#include <algorithm>
+#include <bit>
+#include <utility>
+#include "lib_object_pool.hpp"
+#include "lib_formatter.hpp"
+
+#ifndef POOL_STATS_TIMESTAMP
+#if __has_include("esp_timer.h")
+#include "esp_timer.h"
+#define POOL_STATS_TIMESTAMP() uint32_t(esp_timer_get_time())
+#else
+#include <chrono>
+#define POOL_STATS_TIMESTAMP() uint32_t(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count())
+#endif
+#endif
+
+//opt-in ObjectPool instrumentation:
+//  ObjectPool<Msg, 32, PoolStats> g_Msgs;
+//  FMT_PRINTLN("msgs: {}", g_Msgs.GetStats());
+//Counters are plain fields, reading them costs nothing. They follow the pool's own
+//synchronization (i.e. none: guard the pool and you guard its stats).
+template<size_t N>
+struct PoolStats
+{
+    //lifetime histogram: bucket 0 counts objects released within kLifetimeUnitUs,
+    //bucket b the ones released within [kLifetimeUnitUs << (b-1), kLifetimeUnitUs << b), the last one everything longer
+    static constexpr size_t kLifetimeBuckets = 16;
+    static constexpr uint32_t kLifetimeUnitUs = 64;
+
+    uint32_t live = 0;
+    uint32_t highWater = 0;
+    uint32_t failedAcquires = 0;
+    uint32_t acquires = 0;
+    uint32_t releases = 0;
+    uint32_t sinceUs = POOL_STATS_TIMESTAMP();//start of the rate window, see Reset()
+    uint32_t lifetime[kLifetimeBuckets] = {};
+
+    void OnAcquire(size_t idx)
+    {
+        ++acquires;
+        highWater = std::max(highWater, ++live);
+        m_AcquiredAt[idx] = POOL_STATS_TIMESTAMP();
+    }
+
+    void OnAcquireFailed() { ++failedAcquires; }
+
+    void OnRelease(size_t idx)
+    {
+        ++releases;
+        --live;
+        const uint32_t dt = (POOL_STATS_TIMESTAMP() - m_AcquiredAt[idx]) / kLifetimeUnitUs;
+        ++lifetime[std::min<size_t>(std::bit_width(dt), kLifetimeBuckets - 1)];
+    }
+
+    //per second since the last Reset()
+    uint32_t AcquireRate() const { return rate(acquires); }
+    uint32_t ReleaseRate() const { return rate(releases); }
+
+    //starts a new window for the rates and the histogram; live objects and the high-water mark stay
+    void Reset()
+    {
+        failedAcquires = acquires = releases = 0;
+        std::fill(std::begin(lifetime), std::end(lifetime), 0);
+        sinceUs = POOL_STATS_TIMESTAMP();
+    }
+
+private:
+    uint32_t rate(uint32_t n) const
+    {
+        const uint32_t dt = POOL_STATS_TIMESTAMP() - sinceUs;
+        return dt ? uint32_t(uint64_t(n) * 1000000 / dt) : 0;
+    }
+
+    uint32_t m_AcquiredAt[N];
+};
+
+//live 3/32 max 17 failed 0 acq 1200 (40/s) rel 1197 (39/s) life[1100 80 17 0 0 0 0 0 0 0 0 0 0 0 0 0]
+template<size_t N>
+struct tools::formatter_t<PoolStats<N>>
+{
+    template<FormatDestination Dest>
+    static std::expected<size_t, FormatError> format_to(Dest &&dst, std::string_view const& fmtStr, PoolStats<N> const& s)
+    {
+        //written piece by piece: a nested tools::format_to would finish (flush) dst in the middle of the record
+        const std::pair<std::string_view, uint32_t> fields[] = {
+            {"live ", s.live}, {"/", uint32_t(N)}, {" max ", s.highWater}, {" failed ", s.failedAcquires},
+            {" acq ", s.acquires}, {" (", s.AcquireRate()}, {"/s) rel ", s.releases}, {" (", s.ReleaseRate()}
+        };
+        size_t len = 0;
+        for(auto const& [label, v] : fields)
+        {
+            dst(label);
+            auto r = format_arg_to(dst, std::string_view{}, v);
+            if (!r)
+                return r;
+            len += label.size() + *r;
+        }
+        constexpr std::string_view kLife = "/s) life[";
+        dst(kLife);
+        len += kLife.size();
+        for(size_t b = 0; b < PoolStats<N>::kLifetimeBuckets; ++b)
+        {
+            if (b)
+            {
+                dst(' ');
+                ++len;
+            }
+            auto rb = format_arg_to(dst, std::string_view{}, s.lifetime[b]);
+            if (!rb)
+                return rb;
+            len += *rb;
+        }
+        dst(']');
+        return len + 1;
+    }
+};
+
+#endif
@@ -1,6 +1,8 @@
 #ifndef LIB_RING_BUFFER_HPP_
 #define LIB_RING_BUFFER_HPP_
 
+#include <atomic>
+#include <bit>
 #include <cstddef>
 #include <optional>
 #include "lib_misc_helpers.hpp"
@@ -96,4 +98,203 @@ private:
     size_type m_Tail = 0;
 };
 
+//single-producer/single-consumer lock-free variant, e.g. ISR -> task streaming.
+//push/peek/pop/drop may run concurrently as long as there's exactly one producer (push)
+//and one consumer (everything else). Capacity is N rounded up to a power of 2.
+//Producer and consumer indices live on separate cache lines, each side also keeps a cached copy of
+//the other side's index and only reloads it (acquire) when the ring looks full/empty.
+template<class T, size_t N>
+struct SpscRingBuffer
+{
+    static_assert(N > 0 && N <= (size_t(1) << 31));
+    constexpr static uint32_t kBufSize = std::bit_ceil(uint32_t(N));
+    constexpr static uint32_t kMask = kBufSize - 1;
+
+    SpscRingBuffer() = default;
+    SpscRingBuffer(const SpscRingBuffer&) = delete;
+    SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+    ~SpscRingBuffer()
+    {
+        if constexpr (!std::is_trivially_destructible_v<T>)
+            while(drop());
+    }
+
+    //producer
+    template<class... Args>
+    bool push(Args&&...args)
+    {
+        const uint32_t t = m_Tail.load(std::memory_order_relaxed);
+        if (t - m_CachedHead == kBufSize)
+        {
+            m_CachedHead = m_Head.load(std::memory_order_acquire);
+            if (t - m_CachedHead == kBufSize) return false;
+        }
+        new (&(m_Buf[t & kMask].item)) T{std::forward<Args>(args)...};
+        m_Tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    //consumer
+    std::optional<T> pop()
+    {
+        T *pItem = peek();
+        if (!pItem) return std::nullopt;
+        ScopeExit cleanup = [&]{ drop_front(); };
+        return std::move(*pItem);
+    }
+
+    //consumer
+    bool drop()
+    {
+        if (!peek()) return false;
+        drop_front();
+        return true;
+    }
+
+    //consumer
+    T* peek()
+    {
+        const uint32_t h = m_Head.load(std::memory_order_relaxed);
+        if (h == m_CachedTail)
+        {
+            m_CachedTail = m_Tail.load(std::memory_order_acquire);
+            if (h == m_CachedTail) return nullptr;
+        }
+        return &m_Buf[h & kMask].item;
+    }
+
+    //either side, a snapshot
+    size_t size() const { return m_Tail.load(std::memory_order_acquire) - m_Head.load(std::memory_order_acquire); }
+    bool empty() const { return size() == 0; }
+
+private:
+    void drop_front()
+    {
+        const uint32_t h = m_Head.load(std::memory_order_relaxed);
+        if constexpr (!std::is_trivially_destructible_v<T>)
+            m_Buf[h & kMask].item.~T();
+        m_Head.store(h + 1, std::memory_order_release);
+    }
+
+    union Raw
+    {
+        Raw() {}
+        ~Raw() {}
+        T item;
+    };
+
+    //producer side
+    alignas(kCacheLineSize) std::atomic<uint32_t> m_Tail{0};
+    uint32_t m_CachedHead = 0;
+    //consumer side
+    alignas(kCacheLineSize) std::atomic<uint32_t> m_Head{0};
+    uint32_t m_CachedTail = 0;
+    alignas(kCacheLineSize) Raw m_Buf[kBufSize];
+};
+
+//bounded multi-producer/multi-consumer queue (Vyukov): every cell carries a sequence number telling
+//whether it's ready to be written (seq == pos) or read (seq == pos + 1) for the lap of a given position,
+//so producers and consumers only contend on their own position counter (one CAS each).
+//Capacity is N rounded up to a power of 2, no heap.
+template<class T, size_t N>
+struct MpmcQueue
+{
+    static_assert(N > 1 && N <= (size_t(1) << 31));
+    constexpr static uint32_t kBufSize = std::bit_ceil(uint32_t(N));
+    constexpr static uint32_t kMask = kBufSize - 1;
+
+    MpmcQueue()
+    {
+        for(uint32_t i = 0; i < kBufSize; ++i)
+            m_Buf[i].seq.store(i, std::memory_order_relaxed);
+    }
+    MpmcQueue(const MpmcQueue&) = delete;
+    MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+    ~MpmcQueue()
+    {
+        if constexpr (!std::is_trivially_destructible_v<T>)
+            while(pop());
+    }
+
+    //false if full
+    template<class... Args>
+    bool push(Args&&...args)
+    {
+        uint32_t pos = m_Tail.load(std::memory_order_relaxed);
+        Cell *pCell;
+        while(true)
+        {
+            pCell = &m_Buf[pos & kMask];
+            const int32_t dif = int32_t(pCell->seq.load(std::memory_order_acquire) - pos);
+            if (dif == 0)
+            {
+                if (m_Tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (dif < 0)
+                return false;//the cell still holds the item of the previous lap
+            else
+                pos = m_Tail.load(std::memory_order_relaxed);
+        }
+        new (&pCell->data.item) T{std::forward<Args>(args)...};
+        pCell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    std::optional<T> pop()
+    {
+        uint32_t pos = m_Head.load(std::memory_order_relaxed);
+        Cell *pCell;
+        while(true)
+        {
+            pCell = &m_Buf[pos & kMask];
+            const int32_t dif = int32_t(pCell->seq.load(std::memory_order_acquire) - (pos + 1));
+            if (dif == 0)
+            {
+                if (m_Head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (dif < 0)
+                return std::nullopt;//empty
+            else
+                pos = m_Head.load(std::memory_order_relaxed);
+        }
+        ScopeExit cleanup = [&]{
+            if constexpr (!std::is_trivially_destructible_v<T>)
+                pCell->data.item.~T();
+            pCell->seq.store(pos + kBufSize, std::memory_order_release);
+        };
+        return std::move(pCell->data.item);
+    }
+
+    //a snapshot, may be off while operations are in flight
+    size_t size() const
+    {
+        const uint32_t t = m_Tail.load(std::memory_order_acquire);
+        const uint32_t h = m_Head.load(std::memory_order_acquire);
+        return int32_t(t - h) > 0 ? t - h : 0;
+    }
+    bool empty() const { return size() == 0; }
+
+private:
+    union Raw
+    {
+        Raw() {}
+        ~Raw() {}
+        T item;
+    };
+
+    struct Cell
+    {
+        std::atomic<uint32_t> seq;
+        Raw data;
+    };
+
+    alignas(kCacheLineSize) std::atomic<uint32_t> m_Tail{0};
+    alignas(kCacheLineSize) std::atomic<uint32_t> m_Head{0};
+    alignas(kCacheLineSize) Cell m_Buf[kBufSize];
+};
+
 #endif
@@ -0,0 +1,134 @@
+#ifndef LIB_SIGNAL_HPP_
+#define LIB_SIGNAL_HPP_
+
+#include <cstdint>
+#include <optional>
+#include "lib_function.hpp"
+
+//identifies a connection of a Signal, returned by connect() and used by disconnect()
+struct SignalToken
+{
+    uint16_t m_Id;
+
+    bool operator==(SignalToken const&) const = default;
+};
+
+//fixed capacity multicast delegate.
+//Slots are FixedFunction objects stored contiguously (in connection order), no heap.
+//Slots may connect/disconnect (themselves or others) while the signal is being emitted:
+//disconnected slots are skipped right away, destroyed and compacted once the outermost emission is done,
+//slots connected during an emission are called starting with the next one.
+template<class Sig, size_t N, size_t Sz = 48>
+class Signal;
+
+template<class R, class... Args, size_t N, size_t Sz>
+class Signal<R(Args...), N, Sz>
+{
+public:
+    static_assert(N < 0xffff);
+    using Slot = FixedFunction<Sz, R(Args...)>;
+
+    Signal() = default;
+    Signal(const Signal&) = delete;
+    Signal& operator=(const Signal&) = delete;
+
+    template<class F>
+    std::optional<SignalToken> connect(F &&f)
+    {
+        if (m_Size >= N)
+            return std::nullopt;
+        Slot &s = m_Slots[m_Size];
+        s = Slot(std::forward<F>(f));
+        if (!s)
+            return std::nullopt;//spill storage exhausted
+
+        do ++m_NextId; while(!m_NextId || find(m_NextId) < m_Size);
+        m_Ids[m_Size++] = m_NextId;
+        return SignalToken{m_NextId};
+    }
+
+    bool disconnect(SignalToken t)
+    {
+        size_t i = find(t.m_Id);
+        if (i >= m_Size)
+            return false;
+        m_Ids[i] = 0;
+        if (m_EmitDepth)
+            m_Dirty = true;//the slot may be the one running right now
+        else
+            compact();
+        return true;
+    }
+
+    void clear()
+    {
+        for(size_t i = 0; i < m_Size; ++i)
+            m_Ids[i] = 0;
+        if (m_EmitDepth)
+            m_Dirty = true;
+        else
+            compact();
+    }
+
+    size_t size() const { return m_Size; }
+    bool empty() const { return m_Size == 0; }
+
+    //arguments are passed to every slot as lvalues: a slot can't move them away from the next one
+    template<class... A>
+    void emit(A&&... args)
+    {
+        const size_t n = m_Size;
+        ++m_EmitDepth;
+        for(size_t i = 0; i < n; ++i)
+        {
+            if (m_Ids[i])
+                m_Slots[i](args...);
+        }
+        if (!--m_EmitDepth && m_Dirty)
+            compact();
+    }
+
+    template<class... A>
+    void operator()(A&&... args) { emit(std::forward<A>(args)...); }
+
+private:
+    size_t find(uint16_t id) const
+    {
+        for(size_t i = 0; i < m_Size; ++i)
+            if (m_Ids[i] == id)
+                return i;
+        return m_Size;
+    }
+
+    //keeps the connection order
+    void compact()
+    {
+        size_t w = 0;
+        for(size_t i = 0; i < m_Size; ++i)
+        {
+            if (!m_Ids[i])
+            {
+                m_Slots[i].reset();
+                continue;
+            }
+            if (w != i)
+            {
+                m_Slots[w] = std::move(m_Slots[i]);
+                m_Slots[i].reset();
+                m_Ids[w] = m_Ids[i];
+            }
+            ++w;
+        }
+        m_Size = w;
+        m_Dirty = false;
+    }
+
+    Slot m_Slots[N];
+    uint16_t m_Ids[N] = {};
+    uint16_t m_Size = 0;
+    uint16_t m_NextId = 0;
+    uint8_t m_EmitDepth = 0;
+    bool m_Dirty = false;
+};
+
+#endif
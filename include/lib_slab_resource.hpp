@@ -0,0 +1,133 @@
+#ifndef LIB_SLAB_RESOURCE_HPP_
+#define LIB_SLAB_RESOURCE_HPP_
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <memory_resource>
+#include <tuple>
+#include <utility>
+#include "lib_object_pool.hpp"
+
+//one size class of a SlabResource: count blocks of size bytes
+struct slab_class_t
+{
+    size_t size;
+    size_t count;
+};
+
+template<size_t Sz>
+struct alignas(std::min(std::bit_floor(Sz), alignof(std::max_align_t))) SlabBlock
+{
+    std::byte m_Data[Sz];
+};
+
+struct slab_class_stats_t
+{
+    uint32_t allocs = 0;
+    uint32_t live = 0;
+    uint32_t highWater = 0;
+    uint32_t overflows = 0;//requests of this class served by a bigger class or upstream because it was full
+};
+
+//fixed size-class allocator: every class is an ObjectPool of equally sized blocks,
+//a request goes to the smallest class that fits (or the next bigger one with free blocks).
+//No fragmentation, O(number of classes) allocation and deallocation.
+//Requests bigger than the biggest class (or not fitting anywhere) go to the upstream resource,
+//which by default fails with std::bad_alloc.
+//Not synchronized, like ObjectPool.
+//  SlabResource<{16, 32}, {32, 32}, {64, 16}, {128, 8}, {256, 4}> g_Slabs;
+//  std::pmr::vector<int> v(&g_Slabs);
+template<slab_class_t... Classes>
+class SlabResource: public std::pmr::memory_resource
+{
+    static_assert(sizeof...(Classes) > 0);
+    static_assert([]{
+            size_t prev = 0;
+            for(slab_class_t c : {Classes...})
+            {
+                if (c.size <= prev) return false;
+                prev = c.size;
+            }
+            return true;
+        }(), "Slab classes must be sorted by size");
+public:
+    static constexpr size_t kClasses = sizeof...(Classes);
+    static constexpr slab_class_t kClassList[kClasses] = {Classes...};
+
+    SlabResource(std::pmr::memory_resource *pUpstream = std::pmr::null_memory_resource()):
+        m_pUpstream(pUpstream)
+    {}
+
+    slab_class_stats_t const& ClassStats(size_t c) const { return m_Stats[c]; }
+    uint32_t UpstreamAllocs() const { return m_UpstreamAllocs; }
+
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        void *pRes = nullptr;
+        size_t requested = kClasses;
+        [&]<size_t... I>(std::index_sequence<I...>){
+            (try_allocate<I>(bytes, alignment, requested, pRes) || ...);
+        }(std::make_index_sequence<kClasses>{});
+        if (pRes)
+            return pRes;
+
+        if (requested < kClasses)
+            ++m_Stats[requested].overflows;
+        ++m_UpstreamAllocs;
+        return m_pUpstream->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override
+    {
+        bool done = [&]<size_t... I>(std::index_sequence<I...>){
+            return (try_deallocate<I>(p) || ...);
+        }(std::make_index_sequence<kClasses>{});
+        if (!done)
+            m_pUpstream->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+
+private:
+    template<size_t I>
+    using block_t = SlabBlock<kClassList[I].size>;
+
+    template<size_t I>
+    bool try_allocate(size_t bytes, size_t alignment, size_t &requested, void *&pRes)
+    {
+        if (bytes > kClassList[I].size || alignment > alignof(block_t<I>))
+            return false;
+        if (requested == kClasses)
+            requested = I;
+        pRes = std::get<I>(m_Pools).AcquireSlot();
+        if (!pRes)
+            return false;
+
+        auto &s = m_Stats[I];
+        ++s.allocs;
+        s.highWater = std::max(s.highWater, ++s.live);
+        if (requested != I)
+            ++m_Stats[requested].overflows;
+        return true;
+    }
+
+    template<size_t I>
+    bool try_deallocate(void *p)
+    {
+        auto &pool = std::get<I>(m_Pools);
+        if (!pool.Owns(p))
+            return false;
+        pool.ReleaseSlot((block_t<I>*)p);
+        --m_Stats[I].live;
+        return true;
+    }
+
+    std::tuple<ObjectPool<SlabBlock<Classes.size>, Classes.count>...> m_Pools;
+    slab_class_stats_t m_Stats[kClasses];
+    uint32_t m_UpstreamAllocs = 0;
+    std::pmr::memory_resource *m_pUpstream;
+};
+
+#endif
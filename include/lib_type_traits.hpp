@@ -38,6 +38,9 @@ struct MinSizeType<N> { using type = uint8_t; };
 template<size_t N> requires (N > 255 && N <= 65535)
 struct MinSizeType<N> { using type = uint16_t; };
 
+//padding/alignment unit to keep data written by different cores apart
+inline constexpr size_t kCacheLineSize = 64;
+
 template<size_t N>
 struct MinBitSizeType { using type = size_t; };
 template<size_t N> requires (N <= 7)
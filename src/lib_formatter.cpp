@@ -0,0 +1,507 @@
+#include "lib_formatter.hpp"
+
+namespace tools
+{
+    /**********************************************************************/
+    /* Shortest round-trip float -> decimal (Ryu, f2s variant)            */
+    /* Only integer arithmetic, at most 32x32->64 multiplications         */
+    /**********************************************************************/
+    namespace
+    {
+        constexpr int32_t kFloatMantissaBits = 23;
+        constexpr int32_t kFloatBias = 127;
+        constexpr int32_t kFloatPow5InvBitCount = 59;
+        constexpr int32_t kFloatPow5BitCount = 61;
+
+        constexpr uint64_t g_FloatPow5InvSplit[31] = {
+        576460752303423489ull, 461168601842738791ull, 368934881474191033ull,
+        295147905179352826ull, 472236648286964522ull, 377789318629571618ull,
+        302231454903657294ull, 483570327845851670ull, 386856262276681336ull,
+        309485009821345069ull, 495176015714152110ull, 396140812571321688ull,
+        316912650057057351ull, 507060240091291761ull, 405648192073033409ull,
+        324518553658426727ull, 519229685853482763ull, 415383748682786211ull,
+        332306998946228969ull, 531691198313966350ull, 425352958651173080ull,
+        340282366920938464ull, 544451787073501542ull, 435561429658801234ull,
+        348449143727040987ull, 557518629963265579ull, 446014903970612463ull,
+        356811923176489971ull, 570899077082383953ull, 456719261665907162ull,
+        365375409332725730ull,
+        };
+
+        constexpr uint64_t g_FloatPow5Split[47] = {
+        1152921504606846976ull, 1441151880758558720ull, 1801439850948198400ull,
+        2251799813685248000ull, 1407374883553280000ull, 1759218604441600000ull,
+        2199023255552000000ull, 1374389534720000000ull, 1717986918400000000ull,
+        2147483648000000000ull, 1342177280000000000ull, 1677721600000000000ull,
+        2097152000000000000ull, 1310720000000000000ull, 1638400000000000000ull,
+        2048000000000000000ull, 1280000000000000000ull, 1600000000000000000ull,
+        2000000000000000000ull, 1250000000000000000ull, 1562500000000000000ull,
+        1953125000000000000ull, 1220703125000000000ull, 1525878906250000000ull,
+        1907348632812500000ull, 1192092895507812500ull, 1490116119384765625ull,
+        1862645149230957031ull, 1164153218269348144ull, 1455191522836685180ull,
+        1818989403545856475ull, 2273736754432320594ull, 1421085471520200371ull,
+        1776356839400250464ull, 2220446049250313080ull, 1387778780781445675ull,
+        1734723475976807094ull, 2168404344971008868ull, 1355252715606880542ull,
+        1694065894508600678ull, 2117582368135750847ull, 1323488980084844279ull,
+        1654361225106055349ull, 2067951531382569187ull, 1292469707114105741ull,
+        1615587133892632177ull, 2019483917365790221ull,
+        };
+
+        //ceil(log2(5^e)) for e > 0
+        int32_t pow5bits(int32_t e) { return int32_t((uint32_t(e) * 1217359) >> 19) + 1; }
+        //floor(log10(2^e))
+        uint32_t log10Pow2(int32_t e) { return (uint32_t(e) * 78913) >> 18; }
+        //floor(log10(5^e))
+        uint32_t log10Pow5(int32_t e) { return (uint32_t(e) * 732923) >> 20; }
+
+        uint32_t pow5factor(uint32_t v)
+        {
+            uint32_t count = 0;
+            for(; v % 5 == 0; v /= 5)
+                ++count;
+            return count;
+        }
+
+        bool multipleOfPowerOf5(uint32_t v, uint32_t p) { return pow5factor(v) >= p; }
+        bool multipleOfPowerOf2(uint32_t v, uint32_t p) { return (v & ((1u << p) - 1)) == 0; }
+
+        uint32_t mulShift(uint32_t m, uint64_t factor, int32_t shift)
+        {
+            const uint64_t bits0 = uint64_t(m) * uint32_t(factor);
+            const uint64_t bits1 = uint64_t(m) * uint32_t(factor >> 32);
+            const uint64_t sum = (bits0 >> 32) + bits1;
+            return uint32_t(sum >> (shift - 32));
+        }
+    }
+
+    decimal_fp32_t float_to_decimal(uint32_t ieeeMantissa, uint32_t ieeeExponent)
+    {
+        int32_t e2;
+        uint32_t m2;
+        if (ieeeExponent == 0)
+        {
+            e2 = 1 - kFloatBias - kFloatMantissaBits - 2;
+            m2 = ieeeMantissa;
+        }else
+        {
+            e2 = int32_t(ieeeExponent) - kFloatBias - kFloatMantissaBits - 2;
+            m2 = (1u << kFloatMantissaBits) | ieeeMantissa;
+        }
+        const bool acceptBounds = (m2 & 1) == 0;
+
+        //interval of valid decimal representations
+        const uint32_t mv = 4 * m2;
+        const uint32_t mp = 4 * m2 + 2;
+        const uint32_t mmShift = ieeeMantissa != 0 || ieeeExponent <= 1;
+        const uint32_t mm = 4 * m2 - 1 - mmShift;
+
+        uint32_t vr, vp, vm;
+        int32_t e10;
+        bool vmIsTrailingZeros = false;
+        bool vrIsTrailingZeros = false;
+        uint8_t lastRemovedDigit = 0;
+        if (e2 >= 0)
+        {
+            const uint32_t q = log10Pow2(e2);
+            e10 = int32_t(q);
+            const int32_t k = kFloatPow5InvBitCount + pow5bits(q) - 1;
+            const int32_t i = -e2 + int32_t(q) + k;
+            vr = mulShift(mv, g_FloatPow5InvSplit[q], i);
+            vp = mulShift(mp, g_FloatPow5InvSplit[q], i);
+            vm = mulShift(mm, g_FloatPow5InvSplit[q], i);
+            if (q != 0 && (vp - 1) / 10 <= vm / 10)
+            {
+                //one removed digit is needed even if the loop below doesn't run
+                const int32_t l = kFloatPow5InvBitCount + pow5bits(q - 1) - 1;
+                lastRemovedDigit = uint8_t(mulShift(mv, g_FloatPow5InvSplit[q - 1], -e2 + int32_t(q) - 1 + l) % 10);
+            }
+            if (q <= 9)
+            {
+                //only one of mp, mv and mm can be a multiple of 5, if any
+                if (mv % 5 == 0)
+                    vrIsTrailingZeros = multipleOfPowerOf5(mv, q);
+                else if (acceptBounds)
+                    vmIsTrailingZeros = multipleOfPowerOf5(mm, q);
+                else
+                    vp -= multipleOfPowerOf5(mp, q);
+            }
+        }else
+        {
+            const uint32_t q = log10Pow5(-e2);
+            e10 = int32_t(q) + e2;
+            const int32_t i = -e2 - int32_t(q);
+            const int32_t k = pow5bits(i) - kFloatPow5BitCount;
+            int32_t j = int32_t(q) - k;
+            vr = mulShift(mv, g_FloatPow5Split[i], j);
+            vp = mulShift(mp, g_FloatPow5Split[i], j);
+            vm = mulShift(mm, g_FloatPow5Split[i], j);
+            if (q != 0 && (vp - 1) / 10 <= vm / 10)
+            {
+                j = int32_t(q) - 1 - (pow5bits(i + 1) - kFloatPow5BitCount);
+                lastRemovedDigit = uint8_t(mulShift(mv, g_FloatPow5Split[i + 1], j) % 10);
+            }
+            if (q <= 1)
+            {
+                //mv = 4 * m2 always has at least two trailing 0 bits
+                vrIsTrailingZeros = true;
+                if (acceptBounds)
+                    vmIsTrailingZeros = mmShift == 1;
+                else
+                    --vp;
+            }else if (q < 31)
+                vrIsTrailingZeros = multipleOfPowerOf2(mv, q - 1);
+        }
+
+        //shortest representation in the interval
+        int32_t removed = 0;
+        uint32_t output;
+        if (vmIsTrailingZeros || vrIsTrailingZeros)
+        {
+            //rare general case
+            while(vp / 10 > vm / 10)
+            {
+                vmIsTrailingZeros &= vm % 10 == 0;
+                vrIsTrailingZeros &= lastRemovedDigit == 0;
+                lastRemovedDigit = uint8_t(vr % 10);
+                vr /= 10;
+                vp /= 10;
+                vm /= 10;
+                ++removed;
+            }
+            if (vmIsTrailingZeros)
+            {
+                while(vm % 10 == 0)
+                {
+                    vrIsTrailingZeros &= lastRemovedDigit == 0;
+                    lastRemovedDigit = uint8_t(vr % 10);
+                    vr /= 10;
+                    vp /= 10;
+                    vm /= 10;
+                    ++removed;
+                }
+            }
+            if (vrIsTrailingZeros && lastRemovedDigit == 5 && vr % 2 == 0)
+                lastRemovedDigit = 4;//round to even for exact .....50..0
+            output = vr + ((vr == vm && (!acceptBounds || !vmIsTrailingZeros)) || lastRemovedDigit >= 5);
+        }else
+        {
+            while(vp / 10 > vm / 10)
+            {
+                lastRemovedDigit = uint8_t(vr % 10);
+                vr /= 10;
+                vp /= 10;
+                vm /= 10;
+                ++removed;
+            }
+            output = vr + (vr == vm || lastRemovedDigit >= 5);
+        }
+        return {output, e10 + removed};
+    }
+
+    namespace
+    {
+        //drops 'drop' trailing digits of m rounding half up
+        uint32_t round_off_digits(uint32_t m, uint8_t olength, int32_t drop)
+        {
+            if (drop <= 0)
+                return m;
+            if (drop > olength)
+                return 0;
+            if (drop == olength)
+                return m >= 5 * g_DecimalFactors[olength - 1];
+            const uint32_t f = g_DecimalFactors[drop];
+            uint32_t q = m / f;
+            return q + ((m - q * f) >= f / 2);
+        }
+
+        char* put_zeros(char *p, int32_t n)
+        {
+            if (n > 0)
+            {
+                std::memset(p, '0', n);
+                p += n;
+            }
+            return p;
+        }
+    }
+
+    size_t format_float_to_buf(char *pBuf, float v, format_spec_t const& spec)
+    {
+        char *p = pBuf;
+        const uint32_t bits = std::bit_cast<uint32_t>(v);
+        const uint32_t ieeeMantissa = bits & ((1u << kFloatMantissaBits) - 1);
+        const uint32_t ieeeExponent = (bits >> kFloatMantissaBits) & 0xff;
+        const bool neg = (bits >> 31) != 0;
+
+        if (ieeeExponent == 0xff)
+        {
+            if (ieeeMantissa)
+            {
+                std::memcpy(p, "nan", 3);
+                return 3;
+            }
+            if (neg)
+                *p++ = '-';
+            std::memcpy(p, "inf", 3);
+            return p + 3 - pBuf;
+        }
+
+        if (neg)
+            *p++ = '-';
+
+        decimal_fp32_t d{0, 0};
+        if (ieeeExponent || ieeeMantissa)
+            d = float_to_decimal(ieeeMantissa, ieeeExponent);
+        uint8_t olength = decimal_digits_count(d.mantissa);
+        const int32_t precision = std::min<int32_t>(spec.precision, kFloatMaxPrecision);
+
+        //decimal exponent of the leading digit
+        int32_t x = olength - 1 + d.exponent;
+        if (d.mantissa && (x >= kFloatPosExp10Threshold || x <= kFloatNegExp10Threshold))
+        {
+            //d.ddd e x
+            if (precision >= 0 && olength > precision + 1)
+            {
+                d.mantissa = round_off_digits(d.mantissa, olength, olength - (precision + 1));
+                olength = precision + 1;
+                if (d.mantissa == g_DecimalFactors[olength])
+                {
+                    d.mantissa /= 10;
+                    ++x;
+                }
+            }
+            char digits[10];
+            write_decimal_digits(digits + olength, d.mantissa);
+            *p++ = digits[0];
+            const int32_t decimals = precision >= 0 ? precision : olength - 1;
+            if (decimals > 0)
+            {
+                *p++ = '.';
+                std::memcpy(p, digits + 1, olength - 1);
+                p = put_zeros(p + olength - 1, decimals - (olength - 1));
+            }
+            *p++ = 'e';
+            if (x < 0)
+            {
+                *p++ = '-';
+                x = -x;
+            }
+            char *pEnd = p + decimal_digits_count(uint32_t(x));
+            write_decimal_digits(pEnd, uint32_t(x));
+            return pEnd - pBuf;
+        }
+
+        //fixed notation
+        if (precision >= 0 && -d.exponent > precision)
+        {
+            d.mantissa = round_off_digits(d.mantissa, olength, -d.exponent - precision);
+            d.exponent = -precision;
+            olength = decimal_digits_count(d.mantissa);
+        }
+        if (!d.mantissa)
+            d.exponent = std::min(d.exponent, 0);
+        char digits[10];
+        write_decimal_digits(digits + olength, d.mantissa);
+
+        const int32_t intDigits = olength + d.exponent;
+        const int32_t decimals = std::max(precision, std::max(-d.exponent, 0));
+        if (intDigits <= 0)
+        {
+            *p++ = '0';
+            if (decimals > 0)
+            {
+                *p++ = '.';
+                p = put_zeros(p, -intDigits);
+                std::memcpy(p, digits, olength);
+                p = put_zeros(p + olength, decimals + intDigits - olength);
+            }
+        }else if (intDigits >= olength)
+        {
+            std::memcpy(p, digits, olength);
+            p = put_zeros(p + olength, intDigits - olength);
+            if (decimals > 0)
+            {
+                *p++ = '.';
+                p = put_zeros(p, decimals);
+            }
+        }else
+        {
+            const uint8_t fracDigits = uint8_t(olength - intDigits);
+            std::memcpy(p, digits, intDigits);
+            p += intDigits;
+            *p++ = '.';
+            std::memcpy(p, digits + intDigits, fracDigits);
+            p = put_zeros(p + fracDigits, decimals - fracDigits);
+        }
+        return p - pBuf;
+    }
+}
+
+namespace tools
+{
+    std::expected<size_t, FormatError> vformat_to(FormatSinkRef dst, std::string_view f, std::span<const format_arg_t> args)
+    {
+        size_t res = 0;
+        size_t arg = 0;
+        const char *b = f.data();
+        const char *e = b + f.size();
+        const char *pBegin = b;
+        char prev = 0;
+        for(; b != e; prev = *b++)
+        {
+            if (*b != '{')
+                continue;
+
+            if (prev == '\\')
+            {
+                //escaped: drop the backslash, keep the brace
+                if (b - 1 != pBegin)
+                    dst(std::string_view(pBegin, b - 1));
+                res += b - pBegin - 1;
+                pBegin = b;
+                continue;
+            }
+
+            if (b != pBegin)
+                dst(std::string_view(pBegin, b));
+            res += b - pBegin;
+            ++b;
+            //parse format argument
+            bool explicitNumber;
+            size_t targ;
+            if (b != e && *b >= '0' && *b <= '9')
+            {
+                explicitNumber = true;
+                targ = 0;
+                do
+                {
+                    targ = (targ * 10) + (*b++ - '0');
+                }
+                while(b != e && *b >= '0' && *b <= '9');
+            }else
+            {
+                targ = arg++;
+                explicitNumber = false;
+            }
+
+            if (targ >= args.size())
+                return std::unexpected{explicitNumber ? FormatError::InvalidFormatArgumentNumber : FormatError::NotEnoughFormatArguments};
+
+            if (b != e && *b == ':') ++b;
+            auto pFmtBegin = b;
+            while(b != e && *b != '}')
+                ++b;
+            if (b == e)
+                return std::unexpected(FormatError::InvalidFormatString);
+
+            format_arg_t const& a = args[targ];
+            if (auto r = a.pFormat(dst, std::string_view(pFmtBegin, b), a.pArg); !r)
+                return r;
+            else
+                res += *r;
+            pBegin = b + 1;
+        }
+        if (pBegin != e)
+        {
+            dst(std::string_view(pBegin, e));
+            res += e - pBegin;
+        }
+        dst();
+        return res;
+    }
+}
+
+namespace tools
+{
+    namespace
+    {
+        //8 hex characters of the 4 bytes at pSrc, in memory order
+        void hex_encode_word(char *pDst, const uint8_t *pSrc, bool upper)
+        {
+            uint64_t x = (uint32_t(pSrc[0]) << 24) | (uint32_t(pSrc[1]) << 16) | (uint32_t(pSrc[2]) << 8) | pSrc[3];
+            //spread the nibbles: byte k of x gets nibble k
+            x = ((x & 0x00000000ffff0000ull) << 16) | (x & 0x000000000000ffffull);
+            x = ((x & 0x0000ff000000ff00ull) << 8) | (x & 0x000000ff000000ffull);
+            x = ((x & 0x00f000f000f000f0ull) << 4) | (x & 0x000f000f000f000full);
+            //0x01 in every byte holding a nibble > 9
+            const uint64_t alpha = ((x + 0x0606060606060606ull) >> 4) & 0x0101010101010101ull;
+            x += 0x3030303030303030ull + alpha * (upper ? ('A' - '0' - 10) : ('a' - '0' - 10));
+            //most significant nibble goes first
+            if constexpr (std::endian::native == std::endian::little)
+                x = __builtin_bswap64(x);
+            std::memcpy(pDst, &x, sizeof(x));
+        }
+
+        char* hex_encode_bytes(char *p, const uint8_t *pSrc, size_t n, bool upper, bool spaced)
+        {
+            char w[8];
+            size_t i = 0;
+            for(; i + 4 <= n; i += 4)
+            {
+                hex_encode_word(w, pSrc + i, upper);
+                if (spaced)
+                {
+                    for(size_t b = 0; b < 8; b += 2, p += 3)
+                    {
+                        p[0] = w[b];
+                        p[1] = w[b + 1];
+                        p[2] = ' ';
+                    }
+                }else
+                {
+                    std::memcpy(p, w, 8);
+                    p += 8;
+                }
+            }
+            if (i < n)
+            {
+                uint8_t tail[4] = {};
+                std::memcpy(tail, pSrc + i, n - i);
+                hex_encode_word(w, tail, upper);
+                for(size_t b = 0; b < (n - i) * 2; b += 2)
+                {
+                    *p++ = w[b];
+                    *p++ = w[b + 1];
+                    if (spaced)
+                        *p++ = ' ';
+                }
+            }
+            return p;
+        }
+    }
+
+    size_t hex_encode_block(char *pDst, const uint8_t *pSrc, size_t n, bytes_format_spec_t const& spec)
+    {
+        return hex_encode_bytes(pDst, pSrc, n, spec.upper, !spec.packed) - pDst;
+    }
+
+    size_t hexdump_row(char *pDst, const uint8_t *pSrc, size_t n, size_t offset, bytes_format_spec_t const& spec)
+    {
+        constexpr size_t kHalf = kHexDumpBytesPerRow / 2;
+        char *p = pDst;
+        write_hex_digits(p + 8, offset, 8, spec.upper ? g_HexDigitsUpper : g_HexDigitsLower);
+        p += 8;
+        *p++ = ' ';
+        *p++ = ' ';
+        p = hex_encode_bytes(p, pSrc, std::min(n, kHalf), spec.upper, true);
+        if (n > kHalf)
+        {
+            *p++ = ' ';
+            p = hex_encode_bytes(p, pSrc + kHalf, n - kHalf, spec.upper, true);
+        }
+        if (spec.ascii)
+        {
+            //align the ascii column of a short last row
+            const size_t hexLen = n * 3 + (n > kHalf);
+            const size_t fullLen = kHexDumpBytesPerRow * 3 + 1;
+            std::memset(p, ' ', fullLen - hexLen);
+            p += fullLen - hexLen;
+            *p++ = ' ';
+            *p++ = '|';
+            for(size_t i = 0; i < n; ++i)
+                *p++ = (pSrc[i] >= 0x20 && pSrc[i] < 0x7f) ? char(pSrc[i]) : '.';
+            *p++ = '|';
+        }
+        *p++ = '\n';
+        return p - pDst;
+    }
+}